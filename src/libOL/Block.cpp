@@ -2,127 +2,189 @@
 // Distributed under the MIT License.
 
 #include "Block.h"
+#include "BufferPool.h"
+#include "ByteSource.h"
 #include "ParseException.h"
 
+#include <algorithm>
 #include <fstream>
 #include <cstring>
+#include <utility>
+
+// Marker, absolute time, 32-bit size, type and 32-bit param
+#define BLOCK_MAX_HEADER_LENGTH 14
+
+// Payloads are read from streams this much at a time
+#define BLOCK_STREAM_READ_SIZE (64 * 1024)
 
 namespace libol {
     bool get_bit(uint8_t byte, int n) {
         return (byte >> (7 - n)) & 1;
     }
 
+    Block::Block(const Block& other) {
+        *this = other;
+    }
+
+    static void copyFields(Block& to, const Block& from) {
+        to.offset = from.offset;
+        to.header = from.header;
+        to.channel = from.channel;
+        to.time = from.time;
+        to.type = from.type;
+        to.entityId = from.entityId;
+        to.size = from.size;
+    }
+
+    Block& Block::operator=(const Block& other) {
+        copyFields(*this, other);
+
+        // a copy of an owning block owns its own copy of the payload
+        content = other.content;
+        view = other.view;
+        return *this;
+    }
+
+    Block& Block::operator=(Block&& other) {
+        if (this != &other) {
+            copyFields(*this, other);
+
+            // readers decode block after block into the same Block, so recycle the old payload
+            BufferPool::release(std::move(content));
+            content = std::move(other.content);
+            view = other.view;
+            other.view = ByteSpan();
+        }
+        return *this;
+    }
+
+    Block::~Block() {
+        BufferPool::release(std::move(content));
+    }
+
+    void Block::makeOwning() {
+        if (isOwning()) {
+            return;
+        }
+        std::vector<uint8_t> owned = BufferPool::acquire(view.size);
+        owned.assign(view.begin(), view.end());
+        BufferPool::release(std::move(content));
+        content = std::move(owned);
+        view = ByteSpan();
+    }
+
     Block::Stream Block::createStream(size_t offset) {
         Stream stream(*this, offset);
         return stream;
     }
 
-    Block Block::decode(std::ifstream& ifs) {
-        Block block;
+    // Sets the header's format flags from its marker
+    static void decodeMarker(Block::BlockHeader& header, uint8_t marker) {
+        header.marker = marker;
+        header.timeIsAbs = !get_bit(marker, 0);       // Bit 1: Time format
+        header.sizeIs32 = !get_bit(marker, 3);        // Bit 4: Size size
+        header.hasExplicitType = !get_bit(marker, 1); // Bit 2: Has type
+        header.paramIs32 = !get_bit(marker, 2);       // Bit 3: Blockdata size
+    }
+
+    size_t Block::getHeaderLength(uint8_t marker) {
+        BlockHeader header;
+        decodeMarker(header, marker);
+        return 1 +
+               (header.timeIsAbs ? sizeof(header.timeAbs) : sizeof(header.timeDiff)) +
+               (header.sizeIs32 ? sizeof(header.size32) : sizeof(header.size8)) +
+               (header.hasExplicitType ? sizeof(header.type) : 0) +
+               (header.paramIs32 ? sizeof(header.param32) : sizeof(header.param8));
+    }
 
-        block.offset = ifs.tellg();
+    template<class Source>
+    void Block::decodeHeader(Source& source, Block& block) {
+        block.offset = source.tell();
 
-        block.header.marker = ifs.get();
+        decodeMarker(block.header, source.get());
 
         block.channel = block.header.marker & 0xf;
 
-        // Bit 1: Time format
-        block.header.timeIsAbs = !get_bit(block.header.marker, 0);
         if(block.header.timeIsAbs) {
-            ifs.read(reinterpret_cast<char*>(&block.header.timeAbs), sizeof(block.header.timeAbs));
+            source.read(&block.header.timeAbs);
         } else {
-            block.header.timeDiff = ifs.get();
+            block.header.timeDiff = source.get();
         }
 
-        // Bit 4: Size size
-        block.header.sizeIs32 = !get_bit(block.header.marker, 3);
         if(block.header.sizeIs32) {
-            ifs.read(reinterpret_cast<char*>(&block.header.size32), sizeof(block.header.size32));
+            source.read(&block.header.size32);
             block.size = block.header.size32;
         } else {
-            block.header.size8 = ifs.get();
+            block.header.size8 = source.get();
             block.size = (unsigned) block.header.size8;
         }
 
-        // Bit 2: Has type
-        block.header.hasExplicitType = !get_bit(block.header.marker, 1);
         if(block.header.hasExplicitType) {
-            block.header.type = ifs.get();
+            block.header.type = source.get();
         }
 
-        // Bit 3: Blockdata size
-        block.header.paramIs32 = !get_bit(block.header.marker, 2);
         if(block.header.paramIs32) {
-            ifs.read(reinterpret_cast<char*>(&block.header.param32), sizeof(block.header.param32));
+            source.read(&block.header.param32);
         } else {
-            block.header.param8 = ifs.get();
+            block.header.param8 = source.get();
         }
-
-        // Read content
-        block.content.resize(block.size);
-        ifs.read(reinterpret_cast<char*>(block.content.data()), block.size);
-
-        return block;
     }
 
-    Block Block::decode(uint8_t* buf, size_t& pos, size_t len) {
+    template<class Source>
+    Block Block::decode(Source& source) {
         Block block;
+        decodeHeader(source, block);
 
-        block.offset = pos;
+        // Read content, keeping it in place if the source allows
+        block.view = source.readSpan(block.size);
+        if (!Source::stableSpans) {
+            block.makeOwning();
+        }
 
-        REQUIRE(pos + 1 <= len);
-        block.header.marker = buf[pos++];
+        return block;
+    }
 
-        block.channel = block.header.marker & 0xf;
+#define INSTANTIATE(Source) \
+    template void Block::decodeHeader<Source>(Source&, Block&); \
+    template Block Block::decode<Source>(Source&);
+    LIBOL_FOR_EACH_BYTE_SOURCE(INSTANTIATE)
+#undef INSTANTIATE
 
-        // Bit 1: Time format
-        block.header.timeIsAbs = !get_bit(block.header.marker, 0);
-        if(block.header.timeIsAbs) {
-            REQUIRE(pos + 4 <= len);
-            memcpy(&block.header.timeAbs, buf + pos, sizeof(block.header.timeAbs));
-            pos += 4;
-        } else {
-            REQUIRE(pos + 1 <= len);
-            block.header.timeDiff = buf[pos++];
-        }
-
-        // Bit 4: Size size
-        block.header.sizeIs32 = !get_bit(block.header.marker, 3);
-        if(block.header.sizeIs32) {
-            REQUIRE(pos + 4 <= len);
-            memcpy(&block.header.size32, buf + pos, sizeof(block.header.size32));
-            pos += 4;
-            block.size = block.header.size32;
-        } else {
-            REQUIRE(pos + 1 <= len);
-            block.header.size8 = buf[pos++];
-            block.size = (unsigned) block.header.size8;
-        }
+    Block Block::decode(std::ifstream& ifs) {
+        size_t offset = ifs.tellg();
 
-        // Bit 2: Has type
-        block.header.hasExplicitType = !get_bit(block.header.marker, 1);
-        if(block.header.hasExplicitType) {
-            REQUIRE(pos + 1 < len);
-            block.header.type = buf[pos++];
-        }
+        // the marker says how long the rest of the header is
+        uint8_t header[BLOCK_MAX_HEADER_LENGTH];
+        readFromStream(ifs, header, 1);
+        size_t length = getHeaderLength(header[0]);
+        readFromStream(ifs, header + 1, length - 1);
 
-        // Bit 3: Blockdata size
-        block.header.paramIs32 = !get_bit(block.header.marker, 2);
-        if(block.header.paramIs32) {
-            REQUIRE(pos + 4 <= len);
-            memcpy(&block.header.param32, buf + pos, sizeof(block.header.param32));
-            pos += 4;
-        } else {
-            REQUIRE(pos + 1 <= len);
-            block.header.param8 = buf[pos++];
+        MemorySource source(ByteSpan(header, length));
+        Block block;
+        decodeHeader(source, block);
+        block.offset = offset;
+
+        // a piece at a time, so a garbage size runs into the end of the stream before it's all allocated
+        std::vector<uint8_t> owned = BufferPool::acquire(std::min<size_t>(block.size, BLOCK_STREAM_READ_SIZE));
+        while (owned.size() < block.size) {
+            size_t done = owned.size();
+            owned.resize(std::min<size_t>(block.size, done + BLOCK_STREAM_READ_SIZE));
+            readFromStream(ifs, owned.data() + done, owned.size() - done);
         }
+        block.content = std::move(owned);
+        return block;
+    }
 
-        // Read content
-        block.content.resize(block.size);
-        REQUIRE(pos + block.size <= len);
-        memcpy(block.content.data(), buf + pos, block.size);
-        pos += block.size;
+    Block Block::decode(uint8_t* buf, size_t& pos, size_t len) {
+        Block block = decodeView(buf, pos, len);
+        block.makeOwning();
+        return block;
+    }
 
+    Block Block::decodeView(const uint8_t* buf, size_t& pos, size_t len) {
+        MemorySource source(ByteSpan(buf, len), pos);
+        Block block = decode(source);
+        pos = source.tell();
         return block;
     }
 }
@@ -4,6 +4,7 @@
 #ifndef __libol__Block__
 #define __libol__Block__
 
+#include "ByteSpan.h"
 #include "ParseException.h"
 
 #include <cstdint>
@@ -43,18 +44,41 @@ namespace libol {
         uint32_t entityId; // (?)
         uint32_t size;
 
+        // The payload of blocks that own it: those from decode, and views after makeOwning
         std::vector<uint8_t> content;
 
+        // The payload of blocks from decodeView and the other view readers,
+        // straight in the buffer they were decoded from, which has to outlive
+        // them. Empty for blocks that own their payload.
+        ByteSpan view;
+
+        // The payload, wherever it is
+        ByteSpan payload() const {
+            return view.data ? view : ByteSpan(content.data(), content.size());
+        }
+
+        Block() = default;
+        Block(const Block& other);
+        Block(Block&&) = default;
+        Block& operator=(const Block& other);
+        Block& operator=(Block&& other);
+        ~Block(); // hands content back to the thread's BufferPool, as does assigning over a block
+
+        bool isOwning() const { return !view.data; }
+
+        // Copies a view's payload into content, detaching it from the source buffer
+        void makeOwning();
+
         template<class T>
         void read(T* dest, size_t offset) {
             REQUIRE(offset + sizeof(T) <= this->size);
-            memcpy(dest, this->content.data() + offset, sizeof(T));
+            memcpy(dest, payload().data + offset, sizeof(T));
         }
         template<class T>
         void read(T* dest, size_t offset, size_t count) {
             size_t length = count * sizeof(T);
             REQUIRE(offset + length <= this->size);
-            memcpy(dest, this->content.data() + offset, length);
+            memcpy(dest, payload().data + offset, length);
         }
 
         class Stream {
@@ -92,8 +116,23 @@ namespace libol {
 
         Stream createStream(size_t offset = 0);
 
+        // Spans from a source with stable spans are kept as views, see ByteSource.h
+        template<class Source>
+        static Block decode(Source& source);
+
+        // Reads everything up to the payload into block and leaves source at
+        // the payload; content is left alone
+        template<class Source>
+        static void decodeHeader(Source& source, Block& block);
+
+        // Bytes in a header starting with the given marker, the marker included
+        static size_t getHeaderLength(uint8_t marker);
+
         static Block decode(std::ifstream& ifs);
         static Block decode(uint8_t* buf, size_t& pos, size_t len);
+
+        // Like decode, but without copying the payload out of buf
+        static Block decodeView(const uint8_t* buf, size_t& pos, size_t len);
     };
 }
 
@@ -0,0 +1,79 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__BlockFilter__
+#define __libol__BlockFilter__
+
+#include "Constants.h"
+
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+
+namespace libol {
+    // Which blocks a BlockReader should hand out. Blocks that don't match
+    // still update the reader's delta state, but their payloads are skipped
+    // rather than copied or decoded. A default filter matches everything;
+    // each add narrows it to the values added so far.
+    class BlockFilter {
+        std::bitset<16> channels;
+        bool anyChannel;
+        std::bitset<0x10000> types;
+        bool anyType;
+        std::unordered_set<uint32_t> entityIds;
+        float fromTime;
+        float toTime;
+
+    public:
+        BlockFilter() :
+            anyChannel(true),
+            anyType(true),
+            fromTime(-std::numeric_limits<float>::infinity()),
+            toTime(std::numeric_limits<float>::infinity())
+        {}
+
+        BlockFilter& addChannel(uint8_t channel) {
+            channels.set(channel & 0xf);
+            anyChannel = false;
+            return *this;
+        }
+
+        // Extended types are matched on the real type in the payload, as Packet::decode sees them
+        BlockFilter& addType(PacketType::Id type) {
+            types.set(type);
+            anyType = false;
+            return *this;
+        }
+
+        BlockFilter& addEntity(uint32_t entityId) {
+            entityIds.insert(entityId);
+            return *this;
+        }
+
+        // Blocks with from <= time <= to
+        BlockFilter& setTimeRange(float from, float to) {
+            fromTime = from;
+            toTime = to;
+            return *this;
+        }
+
+        // Everything but the type, which may need the payload to resolve
+        bool matchesHeader(uint8_t channel, uint32_t entityId, float time) const {
+            return (anyChannel || channels.test(channel & 0xf)) &&
+                   (entityIds.empty() || entityIds.count(entityId)) &&
+                   time >= fromTime && time <= toTime;
+        }
+
+        bool matchesType(PacketType::Id type) const {
+            return anyType || types.test(type);
+        }
+
+        // Whether any type will do, so blocks whose type can't be resolved still match
+        bool matchesAnyType() const {
+            return anyType;
+        }
+    };
+}
+
+#endif /* defined(__libol__BlockFilter__) */
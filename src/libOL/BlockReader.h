@@ -5,11 +5,65 @@
 #define __libol__BlockReader__
 
 #include "Block.h"
+#include "BlockFilter.h"
+#include "ByteSource.h"
 
 #include <vector>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
 
 namespace libol {
+    // Single-pass range over blocks that are decoded as the iterator advances,
+    // so only one block is held at a time:
+    //     for (Block& block : reader.blocks(ifs)) { ... }
+    // The block an iterator refers to is overwritten by the next ++.
+    class BlockRange {
+    public:
+        typedef std::function<bool (Block& block)> Next;
+
+        class iterator {
+            Next* next;
+            Block block;
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef Block value_type;
+            typedef ptrdiff_t difference_type;
+            typedef Block* pointer;
+            typedef Block& reference;
+
+            explicit iterator(Next* next) : next(next) {
+                if (next && !(*next)(block)) {
+                    this->next = nullptr;
+                }
+            }
+
+            Block& operator*() { return block; }
+            Block* operator->() { return &block; }
+
+            iterator& operator++() {
+                if (!(*next)(block)) {
+                    next = nullptr;
+                }
+                return *this;
+            }
+
+            // iterators are only ever compared against end()
+            bool operator==(const iterator& other) const { return next == other.next; }
+            bool operator!=(const iterator& other) const { return next != other.next; }
+        };
+
+        explicit BlockRange(Next next) : next(std::move(next)) {}
+
+        iterator begin() { return iterator(&next); }
+        iterator end() { return iterator(nullptr); }
+
+    private:
+        Next next;
+    };
+
     class BlockReader {
         float lastTime;
         uint8_t lastType;
@@ -36,17 +90,138 @@ namespace libol {
             block.entityId = lastEntId;
         }
     public:
+        // The delta state carried from one block to the next. Capturing it at
+        // the start of a chunk lets that chunk be read on its own, e.g. on
+        // another thread, with the same result as reading straight through.
+        struct Checkpoint {
+            float time;
+            uint8_t type;
+            uint32_t entityId;
+
+            Checkpoint() : time(0), type(0), entityId(0) {}
+        };
+
+        BlockReader() : lastTime(0), lastType(0), lastEntId(0) {}
+        explicit BlockReader(const Checkpoint& checkpoint) { restore(checkpoint); }
+
+        Checkpoint checkpoint() const {
+            Checkpoint checkpoint;
+            checkpoint.time = lastTime;
+            checkpoint.type = lastType;
+            checkpoint.entityId = lastEntId;
+            return checkpoint;
+        }
+
+        void restore(const Checkpoint& checkpoint) {
+            lastTime = checkpoint.time;
+            lastType = checkpoint.type;
+            lastEntId = checkpoint.entityId;
+        }
+
+        // Runs through the blocks without keeping them, leaving the state as it is after the last one
+        void skipBuffer(const uint8_t* data, size_t len) {
+            MemorySource source(ByteSpan(data, len));
+            Block block;
+            while (next(source, block)) {}
+        }
+
+        // Decodes the next block into block; false once the source is exhausted.
+        // The last byte of a chunk isn't a block, so a single byte left over counts as the end.
+        template<class Source>
+        bool next(Source& source, Block& block) {
+            if (source.remaining() <= 1) {
+                return false;
+            }
+            block = Block::decode(source);
+            processBlock(block);
+            return true;
+        }
+
+        // Like next, but only stops at blocks that match filter. The others only
+        // have their headers read; their payloads are skipped.
+        template<class Source>
+        bool next(Source& source, Block& block, const BlockFilter& filter) {
+            while (source.remaining() > 1) {
+                Block::decodeHeader(source, block);
+                processBlock(block);
+
+                bool extended = block.type == PacketType::ExtendedType;
+                if (!filter.matchesHeader(block.channel, block.entityId, block.time) ||
+                    (!extended && !filter.matchesType(block.type))) {
+                    source.skip(block.size);
+                    continue;
+                }
+
+                block.view = source.readSpan(block.size);
+                if (extended) {
+                    // too short to hold its real type, so it can only match a filter on no type
+                    if (block.size < sizeof(uint16_t)) {
+                        if (!filter.matchesAnyType()) {
+                            continue;
+                        }
+                    } else {
+                        uint16_t realType;
+                        memcpy(&realType, block.view.data, sizeof(realType));
+                        if (!filter.matchesType(realType)) {
+                            continue;
+                        }
+                    }
+                }
+
+                if (!Source::stableSpans) {
+                    block.makeOwning();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // Decodes the block at pos as a view into data and advances pos past it
+        bool next(const uint8_t* data, size_t& pos, size_t len, Block& block) {
+            MemorySource source(ByteSpan(data, len), pos);
+            bool decoded = next(source, block);
+            pos = source.tell();
+            return decoded;
+        }
+
+        // The stream is read ahead in bulk and left after the last block read once the range goes away
+        BlockRange blocks(std::ifstream& ifs) {
+            std::shared_ptr<FileSource> source = std::make_shared<FileSource>(ifs);
+            return BlockRange([this, source] (Block& block) {
+                return next(*source, block);
+            });
+        }
+
+        // Blocks point into data, which must outlive them
+        BlockRange blockViews(const uint8_t* data, size_t len) {
+            MemorySource source(ByteSpan(data, len));
+            return BlockRange([this, source] (Block& block) mutable {
+                return next(source, block);
+            });
+        }
+
+        // Only the blocks that match filter, see next(source, block, filter)
+        BlockRange blocks(std::ifstream& ifs, const BlockFilter& filter) {
+            std::shared_ptr<FileSource> source = std::make_shared<FileSource>(ifs);
+            return BlockRange([this, source, filter] (Block& block) {
+                return next(*source, block, filter);
+            });
+        }
+
+        BlockRange blockViews(const uint8_t* data, size_t len, const BlockFilter& filter) {
+            MemorySource source(ByteSpan(data, len));
+            return BlockRange([this, source, filter] (Block& block) mutable {
+                return next(source, block, filter);
+            });
+        }
+
         std::vector<Block> readBlocksFromStream(std::ifstream& ifs) {
             std::vector<Block> result;
 
-             while (true) {
-                Block block = Block::decode(ifs);
-                ifs.peek(); // provoke eof
-                if (!ifs.eof()) {
-                    processBlock(block);
-                    result.push_back(block);
-                } else
-                    break;
+            FileSource source(ifs);
+            Block block;
+            while (next(source, block)) {
+                result.push_back(std::move(block));
             }
 
             return result;
@@ -56,11 +231,23 @@ namespace libol {
             std::vector<Block> result;
 
             size_t pos = 0;
+            Block block;
+            while (next(data, pos, len, block)) {
+                block.makeOwning();
+                result.push_back(std::move(block));
+            }
 
-            while (pos < len - 1) {
-                Block block = Block::decode(data, pos, len);
-                processBlock(block);
-                result.push_back(block);
+            return result;
+        }
+
+        // Blocks point into data without copying their payloads, so data must outlive them
+        std::vector<Block> readBlockViewsFromBuffer(const uint8_t* data, size_t len) {
+            std::vector<Block> result;
+
+            size_t pos = 0;
+            Block block;
+            while (next(data, pos, len, block)) {
+                result.push_back(std::move(block));
             }
 
             return result;
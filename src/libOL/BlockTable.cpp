@@ -0,0 +1,79 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "BlockTable.h"
+#include "ByteSource.h"
+
+// Typical blocks are a few dozen bytes, so this is a rough first guess at the row count
+#define EXPECTED_BLOCK_SIZE 32
+
+namespace libol {
+    Block BlockTable::getBlock(size_t index) const {
+        Block block;
+        block.header = Block::BlockHeader();
+        block.offset = payloadOffset[index];
+        block.channel = channel[index];
+        block.time = time[index];
+        block.entityId = entityId[index];
+        block.size = payloadLength[index];
+        block.type = blockType[index];
+        block.view = getPayload(index);
+        return block;
+    }
+
+    std::vector<uint32_t> BlockTable::select(PacketType::Id wanted, float from, float to) const {
+        std::vector<uint32_t> result;
+        const PacketType::Id* types = type.data();
+        const float* times = time.data();
+        size_t rows = size();
+        for (size_t i = 0; i < rows; i++) {
+            if (types[i] == wanted && times[i] >= from && times[i] <= to) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    size_t BlockTable::count(float from, float to) const {
+        const float* times = time.data();
+        size_t rows = size();
+        size_t result = 0;
+        for (size_t i = 0; i < rows; i++) {
+            result += (times[i] >= from) & (times[i] <= to);
+        }
+        return result;
+    }
+
+    BlockTable BlockTable::build(const uint8_t* data, size_t len, BlockReader& reader) {
+        BlockTable table;
+        table.chunk = ByteSpan(data, len);
+
+        size_t expected = len / EXPECTED_BLOCK_SIZE;
+        table.time.reserve(expected);
+        table.type.reserve(expected);
+        table.blockType.reserve(expected);
+        table.entityId.reserve(expected);
+        table.channel.reserve(expected);
+        table.payloadOffset.reserve(expected);
+        table.payloadLength.reserve(expected);
+
+        MemorySource source(table.chunk);
+        Block block;
+        while (reader.next(source, block)) {
+            PacketType::Id type = block.type;
+            if (type == PacketType::ExtendedType && block.size >= sizeof(uint16_t)) {
+                block.read(&type, 0);
+            }
+
+            table.time.push_back(block.time);
+            table.type.push_back(type);
+            table.blockType.push_back(block.type);
+            table.entityId.push_back(block.entityId);
+            table.channel.push_back(block.channel);
+            table.payloadOffset.push_back(block.view.data - data);
+            table.payloadLength.push_back(block.size);
+        }
+
+        return table;
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__BlockTable__
+#define __libol__BlockTable__
+
+#include "Block.h"
+#include "BlockReader.h"
+#include "ByteSpan.h"
+#include "Constants.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace libol {
+    // A decoded chunk's blocks as parallel arrays, one entry per block, so
+    // scans over a column run through contiguous memory. Payloads stay in
+    // the chunk buffer, which must outlive the table. 20 bytes a block,
+    // against 96 for a Block on x86-64.
+    class BlockTable {
+    public:
+        ByteSpan chunk;
+
+        std::vector<float> time;
+        std::vector<PacketType::Id> type; // extended types resolved, as Packet::decode sees them
+        std::vector<uint8_t> blockType;   // as in the block header, ExtendedType for extended ones
+        std::vector<uint32_t> entityId;
+        std::vector<uint8_t> channel;
+        std::vector<uint32_t> payloadOffset; // into chunk
+        std::vector<uint32_t> payloadLength;
+
+        size_t size() const { return time.size(); }
+        bool empty() const { return time.empty(); }
+
+        ByteSpan getPayload(size_t index) const {
+            return chunk.subspan(payloadOffset[index], payloadLength[index]);
+        }
+
+        // The block as BlockReader would have handed it out, as a view into
+        // chunk, e.g. for Packet::decode. The header isn't kept, so offset is
+        // the payload's rather than the block's.
+        Block getBlock(size_t index) const;
+
+        // Indices of the blocks of the given type with from <= time <= to
+        std::vector<uint32_t> select(PacketType::Id type, float from, float to) const;
+
+        // Number of blocks with from <= time <= to, whatever their type
+        size_t count(float from, float to) const;
+
+        /**
+         * Reads the chunk's blocks through reader, which carries the delta
+         * state from the chunk before it, see BlockReader::Checkpoint
+         * \throws ParseException if the chunk is malformed
+         */
+        static BlockTable build(const uint8_t* data, size_t len, BlockReader& reader);
+    };
+}
+
+#endif /* defined(__libol__BlockTable__) */
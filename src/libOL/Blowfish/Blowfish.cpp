@@ -2,8 +2,9 @@
 // Distributed under the MIT License.
 
 #include "Blowfish.h"
+#include "BlowfishKernel.h"
 
-#include <memory>
+#include <cstring>
 #include <stdexcept>
 
 extern "C" {
@@ -12,78 +13,126 @@ extern "C" {
 
 #define BLOCK_SIZE 8
 
-static std::vector<uint8_t> actuallyDoTheCrypto(std::vector<uint8_t> bytes, std::vector<uint8_t> key, bool amEncrypting) {
-        // initialise the blowfish state
-        //std::unique_ptr<BF_KEY> blowfish(new BF_KEY);
-        auto blowfish = new BF_KEY;
-        BF_set_key(blowfish, key.size(), &key[0]);
-
-        // allocate the output buffer
-        std::vector<uint8_t> out;
-        out.resize(bytes.size());
-
-        // loop through and do the crypto
-        // XXX: this code should probably be rewritten
-        auto size = bytes.size();
-        auto encDecFlag = amEncrypting ? BF_ENCRYPT : BF_DECRYPT;
-        for (std::vector<uint8_t>::size_type i = 0; i < size; i += BLOCK_SIZE) {
-                BF_ecb_encrypt(&bytes[i], &out[i], blowfish, encDecFlag);
+namespace libol {
+    namespace Blowfish {
+        struct KeySchedule::State {
+                BF_KEY key;
+        };
+
+        KeySchedule::KeySchedule(const uint8_t* key, size_t length) : state(new State) {
+                BF_set_key(&state->key, length, key);
         }
 
-        return out;
-}
+        KeySchedule::KeySchedule(const std::vector<uint8_t>& key) : KeySchedule(key.data(), key.size()) {}
 
-namespace libol {
-    namespace Blowfish {
-        std::vector<uint8_t> rawDecrypt(std::vector<uint8_t> bytes, std::vector<uint8_t> key) {
-                return ::actuallyDoTheCrypto(bytes, key, false);
+        KeySchedule::KeySchedule(KeySchedule&& other) = default;
+        KeySchedule& KeySchedule::operator=(KeySchedule&& other) = default;
+        KeySchedule::~KeySchedule() = default;
+
+        static void ecb(const uint8_t* in, uint8_t* out, size_t length, const BF_KEY* key, int encDecFlag) {
+                for (size_t i = 0; i + BLOCK_SIZE <= length; i += BLOCK_SIZE) {
+                        BF_ecb_encrypt(in + i, out + i, key, encDecFlag);
+                }
+        }
+
+        static_assert(sizeof(BF_LONG) == sizeof(uint32_t), "the in-tree kernels read BF_KEY as 32-bit words");
+
+        void rawDecrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key) {
+                static const Kernel::Id fastest = getFastestKernel();
+                rawDecrypt(in, out, length, key, fastest);
+        }
+
+        void rawDecrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key, Kernel::Id kernel) {
+                const BF_KEY& bf = key.state->key;
+                switch (kernel) {
+                case Kernel::OpenSSL:
+                        ecb(in, out, length, &bf, BF_DECRYPT);
+                        break;
+                case Kernel::Interleaved:
+                        Kernels::decryptInterleaved(in, out, length / BLOCK_SIZE, bf.P, bf.S);
+                        break;
+                case Kernel::AVX2:
+                        if (!Kernels::hasAVX2()) {
+                                throw std::invalid_argument("The AVX2 kernel isn't supported on this CPU");
+                        }
+                        Kernels::decryptAVX2(in, out, length / BLOCK_SIZE, bf.P, bf.S);
+                        break;
+                }
+        }
+
+        bool isKernelSupported(Kernel::Id kernel) {
+                return kernel != Kernel::AVX2 || Kernels::hasAVX2();
+        }
+
+        Kernel::Id getFastestKernel() {
+                return Kernels::hasAVX2() ? Kernel::AVX2 : Kernel::Interleaved;
+        }
+
+        void rawEncrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key) {
+                ecb(in, out, length, &key.state->key, BF_ENCRYPT);
         }
-        
-        /**
-         * \throws std::invalid_argument if the padding is invalid
-         */
-        std::vector<uint8_t> decrypt(std::vector<uint8_t> bytes, std::vector<uint8_t> key) {
-                auto data = rawDecrypt(bytes, key);
 
-                if (data.size() == 0) {
+        size_t unpaddedLength(const uint8_t* data, size_t length) {
+                if (length == 0) {
                         // don't strip the padding from something with no length...
-                        return data;
+                        return length;
                 }
 
                 // how much padding do we need to remove?
-                uint8_t paddingBytes = *(data.end() - 1);
+                uint8_t paddingBytes = data[length - 1];
 
                 // erm, what?
-                if (paddingBytes > data.size() || paddingBytes > BLOCK_SIZE || paddingBytes == 0) {
+                if (paddingBytes > length || paddingBytes > BLOCK_SIZE || paddingBytes == 0) {
                         throw std::invalid_argument("The padding was invalid");
                 }
 
-                // remove it!
-                data.erase(data.end() - paddingBytes, data.end());
+                return length - paddingBytes;
+        }
 
-                return data;
+        size_t paddedLength(size_t length) {
+                // there's always at least one byte of padding
+                return length - (length % BLOCK_SIZE) + BLOCK_SIZE;
+        }
+
+        size_t decrypt(const uint8_t* in, size_t length, uint8_t* out, const KeySchedule& key) {
+                if (length % BLOCK_SIZE != 0) {
+                        throw std::invalid_argument("The length isn't a whole number of blocks");
+                }
+                rawDecrypt(in, out, length, key);
+                return unpaddedLength(out, length);
         }
-        std::vector<uint8_t> rawEncrypt(std::vector<uint8_t> bytes, std::vector<uint8_t> key) {
-                return ::actuallyDoTheCrypto(bytes, key, true);
+
+        size_t decryptInPlace(uint8_t* data, size_t length, const KeySchedule& key) {
+                return decrypt(data, length, data, key);
         }
-        std::vector<uint8_t> encrypt(std::vector<uint8_t> in_bytes, std::vector<uint8_t> key) {
-                auto bytes = in_bytes;
-                auto size = bytes.size();
 
-                // this needs to be a multiple of BLOCK_SIZE
-                auto paddingSize = BLOCK_SIZE - (size % BLOCK_SIZE);
+        size_t encrypt(const uint8_t* in, size_t length, uint8_t* out, const KeySchedule& key) {
+                size_t whole = length - (length % BLOCK_SIZE);
 
-                // there must be at least some padding
-                if (paddingSize == 0) paddingSize = BLOCK_SIZE;
+                // the trailing partial block is padded with copies of the padding length
+                uint8_t last[BLOCK_SIZE];
+                size_t rest = length - whole;
+                memcpy(last, in + whole, rest);
+                memset(last + rest, BLOCK_SIZE - rest, BLOCK_SIZE - rest);
 
-                // allocate the new size
-                size += (BLOCK_SIZE - (size % BLOCK_SIZE));
-                bytes.reserve(size);
+                rawEncrypt(in, out, whole, key);
+                rawEncrypt(last, out + whole, BLOCK_SIZE, key);
+                return whole + BLOCK_SIZE;
+        }
 
-                // now write the padding
-                bytes.push_back(paddingSize);
+        /**
+         * \throws std::invalid_argument if the padding is invalid
+         */
+        std::vector<uint8_t> decrypt(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key) {
+                std::vector<uint8_t> data(bytes.size());
+                data.resize(decrypt(bytes.data(), bytes.size(), data.data(), KeySchedule(key)));
+                return data;
+        }
 
-                return rawEncrypt(bytes, key);
+        std::vector<uint8_t> encrypt(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key) {
+                std::vector<uint8_t> data(paddedLength(bytes.size()));
+                encrypt(bytes.data(), bytes.size(), data.data(), KeySchedule(key));
+                return data;
         }
     }
 }
@@ -6,11 +6,67 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <memory>
 
 namespace libol {
     namespace Blowfish {
-        std::vector<uint8_t> decrypt(std::vector<uint8_t> bytes, std::vector<uint8_t> key);
-        std::vector<uint8_t> encrypt(std::vector<uint8_t> bytes, std::vector<uint8_t> key);
+        // Decryption implementations. rawDecrypt uses the fastest one the CPU
+        // supports; they all produce the same output as OpenSSL.
+        struct Kernel {
+            enum Id {
+                OpenSSL,     // BF_ecb_encrypt one block at a time
+                Interleaved, // in-tree, four blocks per round
+                AVX2         // in-tree, eight blocks per round in vector lanes
+            };
+        };
+
+        // Expanded key, set up once and reused for any number of blocks.
+        // Movable, not copyable.
+        class KeySchedule {
+            struct State;
+            std::unique_ptr<State> state;
+
+            friend void rawDecrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key, Kernel::Id kernel);
+            friend void rawEncrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key);
+        public:
+            KeySchedule(const uint8_t* key, size_t length);
+            explicit KeySchedule(const std::vector<uint8_t>& key);
+            KeySchedule(KeySchedule&& other);
+            KeySchedule& operator=(KeySchedule&& other);
+            ~KeySchedule();
+        };
+
+        // ECB over whole blocks; length must be a multiple of the block size.
+        // in and out may be the same buffer.
+        void rawDecrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key);
+        void rawDecrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key, Kernel::Id kernel);
+        void rawEncrypt(const uint8_t* in, uint8_t* out, size_t length, const KeySchedule& key);
+
+        bool isKernelSupported(Kernel::Id kernel);
+        Kernel::Id getFastestKernel();
+
+        /**
+         * Length of decrypted data once its trailing padding is stripped
+         * \throws std::invalid_argument if the padding is invalid
+         */
+        size_t unpaddedLength(const uint8_t* data, size_t length);
+
+        // Length of the ciphertext for length bytes of plaintext, padding included
+        size_t paddedLength(size_t length);
+
+        /**
+         * Decrypts into out, which may be in, and returns the plaintext length without padding
+         * \throws std::invalid_argument if length isn't a whole number of blocks or the padding is invalid
+         */
+        size_t decrypt(const uint8_t* in, size_t length, uint8_t* out, const KeySchedule& key);
+        size_t decryptInPlace(uint8_t* data, size_t length, const KeySchedule& key);
+
+        // Pads and encrypts into out, which must hold paddedLength(length) bytes and may be in; returns that length
+        size_t encrypt(const uint8_t* in, size_t length, uint8_t* out, const KeySchedule& key);
+
+        std::vector<uint8_t> decrypt(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key);
+        std::vector<uint8_t> encrypt(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key);
     }
 }
 
@@ -0,0 +1,129 @@
+// Copyright (c) 2014 Luke Granger-Brown.
+// Distributed under the MIT License.
+
+#include "BlowfishKernel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LIBOL_BLOWFISH_AVX2
+#include <immintrin.h>
+#endif
+
+#define BLOCK_SIZE 8
+#define LANES 4
+
+static inline uint32_t load32(const uint8_t* p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void store32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static inline uint32_t feistel(const uint32_t* S, uint32_t x) {
+    return ((S[x >> 24] + S[0x100 + ((x >> 16) & 0xff)]) ^ S[0x200 + ((x >> 8) & 0xff)]) + S[0x300 + (x & 0xff)];
+}
+
+// Decrypts COUNT blocks side by side. Each round's lookups for one block
+// don't depend on the others, so the CPU can overlap their latencies.
+template<size_t COUNT>
+static inline void decryptBlocks(const uint8_t* in, uint8_t* out, const uint32_t* P, const uint32_t* S) {
+    uint32_t l[COUNT], r[COUNT];
+    for (size_t lane = 0; lane < COUNT; lane++) {
+        l[lane] = load32(in + lane * BLOCK_SIZE) ^ P[17];
+        r[lane] = load32(in + lane * BLOCK_SIZE + 4);
+    }
+
+    for (int round = 16; round > 0; round -= 2) {
+        for (size_t lane = 0; lane < COUNT; lane++) {
+            r[lane] ^= P[round] ^ feistel(S, l[lane]);
+        }
+        for (size_t lane = 0; lane < COUNT; lane++) {
+            l[lane] ^= P[round - 1] ^ feistel(S, r[lane]);
+        }
+    }
+
+    for (size_t lane = 0; lane < COUNT; lane++) {
+        store32(out + lane * BLOCK_SIZE, r[lane] ^ P[0]);
+        store32(out + lane * BLOCK_SIZE + 4, l[lane]);
+    }
+}
+
+namespace libol {
+    namespace Blowfish {
+        namespace Kernels {
+            void decryptInterleaved(const uint8_t* in, uint8_t* out, size_t blocks, const uint32_t* P, const uint32_t* S) {
+                size_t i = 0;
+                for (; i + LANES <= blocks; i += LANES) {
+                    decryptBlocks<LANES>(in + i * BLOCK_SIZE, out + i * BLOCK_SIZE, P, S);
+                }
+                for (; i < blocks; i++) {
+                    decryptBlocks<1>(in + i * BLOCK_SIZE, out + i * BLOCK_SIZE, P, S);
+                }
+            }
+
+#ifdef LIBOL_BLOWFISH_AVX2
+            __attribute__((target("avx2")))
+            static inline __m256i feistelAVX2(const int* S, __m256i x) {
+                const __m256i mask = _mm256_set1_epi32(0xff);
+                __m256i a = _mm256_i32gather_epi32(S, _mm256_srli_epi32(x, 24), 4);
+                __m256i b = _mm256_i32gather_epi32(S + 0x100, _mm256_and_si256(_mm256_srli_epi32(x, 16), mask), 4);
+                __m256i c = _mm256_i32gather_epi32(S + 0x200, _mm256_and_si256(_mm256_srli_epi32(x, 8), mask), 4);
+                __m256i d = _mm256_i32gather_epi32(S + 0x300, _mm256_and_si256(x, mask), 4);
+                return _mm256_add_epi32(_mm256_xor_si256(_mm256_add_epi32(a, b), c), d);
+            }
+
+            __attribute__((target("avx2")))
+            void decryptAVX2(const uint8_t* in, uint8_t* out, size_t blocks, const uint32_t* P, const uint32_t* S) {
+                const int* s = reinterpret_cast<const int*>(S);
+                // big-endian words to native and back
+                const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                       3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+                size_t i = 0;
+                for (; i + 8 <= blocks; i += 8) {
+                    const uint8_t* src = in + i * BLOCK_SIZE;
+                    __m256i lo = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), bswap);
+                    __m256i hi = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32)), bswap);
+
+                    // split the halves of each block into separate vectors; the lane
+                    // order gets shuffled but stays the same for both, and is undone below
+                    __m256i l = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+                    __m256i r = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+
+                    l = _mm256_xor_si256(l, _mm256_set1_epi32(P[17]));
+                    for (int round = 16; round > 0; round -= 2) {
+                        r = _mm256_xor_si256(r, _mm256_xor_si256(_mm256_set1_epi32(P[round]), feistelAVX2(s, l)));
+                        l = _mm256_xor_si256(l, _mm256_xor_si256(_mm256_set1_epi32(P[round - 1]), feistelAVX2(s, r)));
+                    }
+                    r = _mm256_xor_si256(r, _mm256_set1_epi32(P[0]));
+
+                    // output blocks are (r, l) pairs
+                    lo = _mm256_castps_si256(_mm256_unpacklo_ps(_mm256_castsi256_ps(r), _mm256_castsi256_ps(l)));
+                    hi = _mm256_castps_si256(_mm256_unpackhi_ps(_mm256_castsi256_ps(r), _mm256_castsi256_ps(l)));
+
+                    uint8_t* dest = out + i * BLOCK_SIZE;
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), _mm256_shuffle_epi8(lo, bswap));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 32), _mm256_shuffle_epi8(hi, bswap));
+                }
+
+                decryptInterleaved(in + i * BLOCK_SIZE, out + i * BLOCK_SIZE, blocks - i, P, S);
+            }
+
+            bool hasAVX2() {
+                return __builtin_cpu_supports("avx2");
+            }
+#else
+            void decryptAVX2(const uint8_t* in, uint8_t* out, size_t blocks, const uint32_t* P, const uint32_t* S) {
+                decryptInterleaved(in, out, blocks, P, S);
+            }
+
+            bool hasAVX2() {
+                return false;
+            }
+#endif
+        }
+    }
+}
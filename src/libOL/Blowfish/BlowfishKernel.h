@@ -0,0 +1,28 @@
+// Copyright (c) 2014 Luke Granger-Brown.
+// Distributed under the MIT License.
+
+#ifndef __libol__BlowfishKernel__
+#define __libol__BlowfishKernel__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libol {
+    namespace Blowfish {
+        // In-tree ECB decryption over an expanded key: P is the 18-entry
+        // subkey array and S the four 256-entry S-boxes laid out back to back,
+        // exactly as in OpenSSL's BF_KEY. Blocks are big-endian like OpenSSL's.
+        namespace Kernels {
+            // Scalar, four independent blocks interleaved per round
+            void decryptInterleaved(const uint8_t* in, uint8_t* out, size_t blocks, const uint32_t* P, const uint32_t* S);
+
+            // Eight blocks per round in AVX2 lanes with gathered S-box lookups;
+            // only call when hasAVX2() is true
+            void decryptAVX2(const uint8_t* in, uint8_t* out, size_t blocks, const uint32_t* P, const uint32_t* S);
+
+            bool hasAVX2();
+        }
+    }
+}
+
+#endif /* defined(__libol__BlowfishKernel__) */
@@ -0,0 +1,108 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "BufferPool.h"
+
+#include <utility>
+
+// Bounds on what one thread keeps around
+#define MAX_POOLED_BUFFERS 64
+#define MAX_POOLED_BYTES (64 * 1024 * 1024)
+
+// Buffers are kept in power-of-two size classes; a request looks at most this many classes up
+#define SIZE_CLASS_SEARCH 2
+
+namespace libol {
+    namespace BufferPool {
+        static const size_t sizeClassCount = sizeof(unsigned long long) * 8;
+
+        struct Pool {
+            // class k holds the buffers with capacities in [2^k, 2^(k+1))
+            std::vector<std::vector<uint8_t>> classes[sizeClassCount];
+            size_t count = 0;
+            size_t bytes = 0;
+
+            ~Pool();
+        };
+
+        // set once the thread's pool is gone, for buffers released during thread teardown
+        static thread_local bool poolDestroyed = false;
+
+        Pool::~Pool() {
+            poolDestroyed = true;
+        }
+
+        static Pool& getPool() {
+            static thread_local Pool pool;
+            return pool;
+        }
+
+        // floor(log2(size)), size > 0
+        static size_t sizeClass(size_t size) {
+            return sizeClassCount - 1 - __builtin_clzll(size);
+        }
+
+        static std::vector<uint8_t> take(Pool& pool, std::vector<std::vector<uint8_t>>& buffers) {
+            std::vector<uint8_t> buffer(std::move(buffers.back()));
+            buffers.pop_back();
+            pool.count--;
+            pool.bytes -= buffer.capacity();
+            return buffer;
+        }
+
+        std::vector<uint8_t> acquire(size_t capacity) {
+            std::vector<uint8_t> buffer;
+            if (capacity == 0) {
+                return buffer;
+            }
+            Pool& pool = getPool();
+
+            // the class capacity falls in only sometimes has a big enough buffer on
+            // top; from the next one up, any will do. Not looking further keeps
+            // small block buffers from using up the chunk-sized ones.
+            size_t first = sizeClass(capacity);
+            auto& own = pool.classes[first];
+            if (!own.empty() && own.back().capacity() >= capacity) {
+                buffer = take(pool, own);
+            } else {
+                for (size_t k = first + 1; k <= first + SIZE_CLASS_SEARCH && k < sizeClassCount; k++) {
+                    if (!pool.classes[k].empty()) {
+                        buffer = take(pool, pool.classes[k]);
+                        break;
+                    }
+                }
+            }
+            buffer.reserve(capacity);
+            return buffer;
+        }
+
+        void release(std::vector<uint8_t>&& buffer) {
+            if (poolDestroyed) {
+                std::vector<uint8_t> discarded(std::move(buffer));
+                return;
+            }
+
+            Pool& pool = getPool();
+            size_t capacity = buffer.capacity();
+            if (capacity == 0 || pool.count >= MAX_POOLED_BUFFERS || pool.bytes + capacity > MAX_POOLED_BYTES) {
+                std::vector<uint8_t> discarded(std::move(buffer));
+                return;
+            }
+
+            buffer.clear();
+            pool.classes[sizeClass(capacity)].push_back(std::move(buffer));
+            pool.count++;
+            pool.bytes += capacity;
+        }
+
+        void clear() {
+            Pool& pool = getPool();
+            for (auto& buffers : pool.classes) {
+                buffers.clear();
+                buffers.shrink_to_fit();
+            }
+            pool.count = 0;
+            pool.bytes = 0;
+        }
+    }
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__BufferPool__
+#define __libol__BufferPool__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libol {
+    // Per-thread free list of byte buffers, so that steady decode loops reuse
+    // chunk and block buffers instead of going back to malloc for each one.
+    // Buffers can be released on a different thread than they were acquired on.
+    namespace BufferPool {
+        // Empty buffer with at least the given capacity, from this thread's pool if one fits
+        std::vector<uint8_t> acquire(size_t capacity);
+
+        // Hands a buffer back to this thread's pool; it's freed instead if the pool is full
+        void release(std::vector<uint8_t>&& buffer);
+
+        // Frees everything pooled on this thread
+        void clear();
+    }
+}
+
+#endif /* defined(__libol__BufferPool__) */
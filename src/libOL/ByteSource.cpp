@@ -0,0 +1,61 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "ByteSource.h"
+
+#include <algorithm>
+
+namespace libol {
+    FileSource::FileSource(std::ifstream& ifs, size_t capacity) : ifs(ifs), capacity(capacity), cursor(0) {
+        std::streamoff start = ifs.tellg();
+        REQUIRE(start >= 0);
+        ifs.seekg(0, std::ios::end);
+        std::streamoff length = ifs.tellg();
+        REQUIRE(length >= start);
+        ifs.seekg(start);
+
+        bufferStart = start;
+        end = length;
+    }
+
+    FileSource::~FileSource() {
+        // hand back whatever was read ahead but not consumed
+        ifs.clear();
+        ifs.seekg(tell());
+    }
+
+    // Makes at least length unread bytes available in the buffer. The stream
+    // is always positioned just after the end of the buffer.
+    void FileSource::fill(size_t length) {
+        REQUIRE(length <= remaining());
+
+        size_t unread = buffer.size() - cursor;
+        memmove(buffer.data(), buffer.data() + cursor, unread);
+        bufferStart += cursor;
+        cursor = 0;
+
+        size_t size = std::min(std::max(length, capacity), end - bufferStart);
+        buffer.resize(size);
+        ifs.read(reinterpret_cast<char *>(buffer.data() + unread), size - unread);
+        REQUIRE((size_t) ifs.gcount() == size - unread);
+    }
+
+    void readFromStream(std::ifstream& ifs, uint8_t* dest, size_t length) {
+        ifs.read(reinterpret_cast<char *>(dest), length);
+        REQUIRE((size_t) ifs.gcount() == length);
+    }
+
+    void FileSource::seek(size_t offset) {
+        if (offset >= bufferStart && offset <= bufferStart + buffer.size()) {
+            cursor = offset - bufferStart;
+            return;
+        }
+
+        REQUIRE(offset <= end);
+        buffer.clear();
+        bufferStart = offset;
+        cursor = 0;
+        ifs.clear();
+        ifs.seekg(offset);
+    }
+}
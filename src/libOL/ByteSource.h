@@ -0,0 +1,159 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__ByteSource__
+#define __libol__ByteSource__
+
+#include "ByteSpan.h"
+#include "MappedFile.h"
+#include "ParseException.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* ByteSource
+ * What the decoders (Header, PayloadHeader, ChunkHeader, Block) are templated on.
+ * A source hands out the bytes of a file or buffer in order:
+ *   template<class T> void read(T* dest, size_t count = 1)  copies count Ts
+ *   uint8_t get()                                          one byte
+ *   ByteSpan readSpan(size_t length)                       borrows length bytes
+ *   void skip(size_t length)                               moves past length bytes without reading them
+ *   size_t tell() const, void seek(size_t offset)          offsets from the start of the source
+ *   size_t remaining() const
+ *   static const bool stableSpans                          whether spans outlive the next read
+ * Reading past the end throws a ParseException.
+ */
+
+// Explicitly instantiates a decoder template for every ByteSource
+#define LIBOL_FOR_EACH_BYTE_SOURCE(X) X(libol::MemorySource) X(libol::FileSource) X(libol::MappedSource)
+
+namespace libol {
+    // Reads from a buffer owned by someone else; spans point into it
+    class MemorySource {
+        ByteSpan span;
+        size_t pos;
+
+    public:
+        static const bool stableSpans = true;
+
+        explicit MemorySource(ByteSpan span, size_t pos = 0) : span(span), pos(pos) {}
+
+        template<class T>
+        void read(T* dest, size_t count = 1) {
+            span.read(dest, pos, count);
+            pos += count * sizeof(T);
+        }
+
+        uint8_t get() {
+            REQUIRE(pos < span.size);
+            return span[pos++];
+        }
+
+        ByteSpan readSpan(size_t length) {
+            ByteSpan result = span.subspan(pos, length);
+            pos += length;
+            return result;
+        }
+
+        void skip(size_t length) {
+            REQUIRE(length <= remaining());
+            pos += length;
+        }
+
+        size_t tell() const { return pos; }
+        void seek(size_t offset) { REQUIRE(offset <= span.size); pos = offset; }
+        size_t remaining() const { return span.size - pos; }
+    };
+
+    // Buffered reads from a stream, a buffer-load at a time instead of field
+    // by field. Spans point into the buffer and only last until the next read.
+    // When the source goes away, the stream is left just after the last byte
+    // read, as if it had been read directly.
+    class FileSource {
+        std::ifstream& ifs;
+        std::vector<uint8_t> buffer;
+        size_t capacity;
+        size_t bufferStart; // stream offset of buffer[0]
+        size_t cursor;      // next unread byte in buffer
+        size_t end;         // stream length
+
+        void fill(size_t length);
+
+    public:
+        static const bool stableSpans = false;
+
+        /**
+         * \param capacity how much to read ahead at a time; small for a single record
+         * \throws ParseException if the stream isn't readable
+         */
+        explicit FileSource(std::ifstream& ifs, size_t capacity = 64 * 1024);
+        FileSource(const FileSource&) = delete;
+        FileSource& operator=(const FileSource&) = delete;
+        ~FileSource();
+
+        template<class T>
+        void read(T* dest, size_t count = 1) {
+            size_t length = count * sizeof(T);
+            if (length > buffer.size() - cursor) {
+                fill(length);
+            }
+            memcpy(dest, buffer.data() + cursor, length);
+            cursor += length;
+        }
+
+        uint8_t get() {
+            if (cursor == buffer.size()) {
+                fill(1);
+            }
+            return buffer[cursor++];
+        }
+
+        ByteSpan readSpan(size_t length) {
+            if (length > buffer.size() - cursor) {
+                fill(length);
+            }
+            ByteSpan result(buffer.data() + cursor, length);
+            cursor += length;
+            return result;
+        }
+
+        // Stays within the buffer if it can, otherwise seeks the stream past the bytes
+        void skip(size_t length) {
+            REQUIRE(length <= remaining());
+            seek(tell() + length);
+        }
+
+        size_t tell() const { return bufferStart + cursor; }
+        void seek(size_t offset);
+        size_t remaining() const { return end - tell(); }
+    };
+
+    /**
+     * Reads length bytes from where the stream is, for the one-off records
+     * that don't need a FileSource and its seeks to find the stream's end
+     * \throws ParseException if the stream ends first
+     */
+    void readFromStream(std::ifstream& ifs, uint8_t* dest, size_t length);
+
+    namespace Detail {
+        struct MappedFileHolder {
+            MappedFile file;
+            explicit MappedFileHolder(const std::string& path) : file(path) {}
+        };
+    }
+
+    // Maps a file and reads from the mapping; spans point into it
+    class MappedSource : private Detail::MappedFileHolder, public MemorySource {
+    public:
+        /**
+         * \throws std::runtime_error if the file can't be opened or mapped
+         */
+        explicit MappedSource(const std::string& path) : MappedFileHolder(path), MemorySource(file.span()) {}
+    };
+}
+
+#endif /* defined(__libol__ByteSource__) */
@@ -0,0 +1,43 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__ByteSpan__
+#define __libol__ByteSpan__
+
+#include "ParseException.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace libol {
+    // Non-owning (pointer, length) view of bytes owned by someone else,
+    // e.g. a memory mapping or a decompressed chunk buffer.
+    struct ByteSpan {
+        const uint8_t* data;
+        size_t size;
+
+        ByteSpan() : data(nullptr), size(0) {}
+        ByteSpan(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        const uint8_t* begin() const { return data; }
+        const uint8_t* end() const { return data + size; }
+        bool empty() const { return size == 0; }
+
+        const uint8_t& operator[](size_t index) const { return data[index]; }
+
+        ByteSpan subspan(size_t offset, size_t count) const {
+            REQUIRE(offset <= size && count <= size - offset);
+            return ByteSpan(data + offset, count);
+        }
+
+        template<class T>
+        void read(T* dest, size_t offset, size_t count = 1) const {
+            size_t length = count * sizeof(T);
+            REQUIRE(offset <= size && length <= size - offset);
+            memcpy(dest, data + offset, length);
+        }
+    };
+}
+
+#endif /* defined(__libol__ByteSpan__) */
@@ -0,0 +1,153 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "ChunkCache.h"
+#include "BufferPool.h"
+
+#include <utility>
+
+// Chunks with more spare capacity than this fraction of their size are copied to an exact-size buffer when cached
+#define CACHE_MAX_SLACK_FRACTION 8
+
+namespace libol {
+    ChunkCache::ChunkCache(size_t byteBudget, size_t shardCount) : byteBudget(byteBudget), bytes(0), clock(0) {
+        if (shardCount == 0) {
+            shardCount = 1;
+        }
+        for (size_t i = 0; i < shardCount; i++) {
+            shards.push_back(std::unique_ptr<Shard>(new Shard));
+        }
+    }
+
+    ChunkCache::Shard& ChunkCache::getShard(const Key& key) const {
+        return *shards[KeyHash()(key) % shards.size()];
+    }
+
+    void ChunkCache::evict() {
+        // Only one thread evicts at a time; the others leave it the work and
+        // carry on. Checking again once it lets go catches whatever they put
+        // while it was finishing up.
+        while (bytes > byteBudget) {
+            std::unique_lock<std::mutex> evictLock(evictMutex, std::try_to_lock);
+            if (!evictLock.owns_lock()) {
+                return;
+            }
+            while (bytes > byteBudget) {
+                if (!evictOldest()) {
+                    return;
+                }
+            }
+        }
+    }
+
+    bool ChunkCache::evictOldest() {
+        // the shard whose least recently used chunk is the oldest
+        Shard* oldest = nullptr;
+        uint64_t oldestUse = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            if (!shard->lru.empty() && (!oldest || shard->lru.back().lastUsed < oldestUse)) {
+                oldest = shard.get();
+                oldestUse = shard->lru.back().lastUsed;
+            }
+        }
+        if (!oldest) {
+            return false;
+        }
+
+        // its tail may have been used or replaced since; whatever is last now goes
+        std::lock_guard<std::mutex> lock(oldest->mutex);
+        if (!oldest->lru.empty()) {
+            Entry& victim = oldest->lru.back();
+            bytes -= victim.bytes;
+            oldest->index.erase(victim.key);
+            oldest->lru.pop_back();
+            oldest->evictions++;
+        }
+        return true;
+    }
+
+    ChunkCache::ChunkPtr ChunkCache::get(uint64_t gameId, int32_t chunkId) {
+        Key key = {gameId, chunkId};
+        Shard& shard = getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            shard.misses++;
+            return nullptr;
+        }
+
+        shard.hits++;
+        found->second->lastUsed = clock++;
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        return found->second->chunk;
+    }
+
+    ChunkCache::ChunkPtr ChunkCache::put(uint64_t gameId, int32_t chunkId, std::vector<uint8_t> chunk) {
+        // pooled buffers can be far bigger than the chunk in them
+        if (chunk.capacity() - chunk.size() > chunk.size() / CACHE_MAX_SLACK_FRACTION) {
+            std::vector<uint8_t> exact(chunk.begin(), chunk.end());
+            BufferPool::release(std::move(chunk));
+            chunk = std::move(exact);
+        }
+
+        Key key = {gameId, chunkId};
+        size_t size = chunk.capacity();
+        ChunkPtr shared = std::make_shared<const std::vector<uint8_t>>(std::move(chunk));
+        if (size > byteBudget) {
+            return shared;
+        }
+
+        {
+            Shard& shard = getShard(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            auto found = shard.index.find(key);
+            if (found != shard.index.end()) {
+                bytes -= found->second->bytes;
+                shard.lru.erase(found->second);
+                shard.index.erase(found);
+            }
+
+            shard.lru.push_front(Entry {key, shared, size, clock++});
+            shard.index[key] = shard.lru.begin();
+            bytes += size;
+        }
+        evict();
+
+        return shared;
+    }
+
+    ChunkCache::ChunkPtr ChunkCache::getOrDecode(uint64_t gameId, int32_t chunkId, const std::function<std::vector<uint8_t> ()>& decode) {
+        ChunkPtr chunk = get(gameId, chunkId);
+        if (chunk) {
+            return chunk;
+        }
+        // two threads missing on the same chunk may both decode it; the later put wins
+        return put(gameId, chunkId, decode());
+    }
+
+    void ChunkCache::clear() {
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            for (auto& entry : shard->lru) {
+                bytes -= entry.bytes;
+            }
+            shard->lru.clear();
+            shard->index.clear();
+        }
+    }
+
+    ChunkCache::Stats ChunkCache::getStats() const {
+        Stats stats = {0, 0, 0, bytes, 0};
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.hits += shard->hits;
+            stats.misses += shard->misses;
+            stats.evictions += shard->evictions;
+            stats.entries += shard->lru.size();
+        }
+        return stats;
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__ChunkCache__
+#define __libol__ChunkCache__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace libol {
+    // Decrypted chunks keyed by (gameId, chunkId), evicted least recently used
+    // first once the cached bytes exceed the budget. The cache is split into
+    // independently locked shards so concurrent readers rarely contend, but
+    // the budget is shared: eviction takes the oldest of the shards' least
+    // recently used chunks, so it's LRU over the whole cache up to the order
+    // of concurrent uses. Bytes are counted by buffer capacity, what's
+    // actually held. Chunks are handed out as shared pointers, so an evicted
+    // chunk stays valid for whoever holds it.
+    class ChunkCache {
+    public:
+        typedef std::shared_ptr<const std::vector<uint8_t>> ChunkPtr;
+
+        struct Stats {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            size_t bytes;
+            size_t entries;
+        };
+
+    private:
+        struct Key {
+            uint64_t gameId;
+            int32_t chunkId;
+
+            bool operator==(const Key& other) const {
+                return gameId == other.gameId && chunkId == other.chunkId;
+            }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const {
+                return std::hash<uint64_t>()(key.gameId * 0x9e3779b97f4a7c15ull ^ (uint32_t) key.chunkId);
+            }
+        };
+
+        struct Entry {
+            Key key;
+            ChunkPtr chunk;
+            size_t bytes; // the chunk's capacity
+            uint64_t lastUsed; // from clock
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<Entry> lru; // most recently used first
+            std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+        };
+
+        size_t byteBudget;
+        std::atomic<size_t> bytes;
+        std::atomic<uint64_t> clock; // ticks on every use, to compare recency across shards
+        std::mutex evictMutex; // one evicting thread at a time, taken before any shard's
+        std::vector<std::unique_ptr<Shard>> shards;
+
+        Shard& getShard(const Key& key) const;
+        void evict();
+        bool evictOldest(); // false if there's nothing left to evict
+
+    public:
+        /**
+         * \param byteBudget upper bound on the bytes held, counting buffer capacity
+         * \param shardCount number of independently locked shards
+         */
+        explicit ChunkCache(size_t byteBudget, size_t shardCount = 16);
+
+        // Returns nullptr on a miss
+        ChunkPtr get(uint64_t gameId, int32_t chunkId);
+
+        // Stores a chunk, replacing any previous one; chunks bigger than the whole budget aren't kept
+        ChunkPtr put(uint64_t gameId, int32_t chunkId, std::vector<uint8_t> chunk);
+
+        // Returns the cached chunk, or decodes and caches it. Decoding runs outside the shard's lock.
+        ChunkPtr getOrDecode(uint64_t gameId, int32_t chunkId, const std::function<std::vector<uint8_t> ()>& decode);
+
+        void clear();
+        Stats getStats() const;
+    };
+}
+
+#endif /* defined(__libol__ChunkCache__) */
@@ -0,0 +1,234 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "ChunkDecoder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+#include <zlib.h>
+}
+
+#include "Blowfish/Blowfish.h"
+#include "BufferPool.h"
+
+// Plaintext fed to inflate per step, and output handed to a sink per call.
+// The input window must be a whole number of Blowfish blocks.
+#define INPUT_WINDOW_SIZE 4096
+#define OUTPUT_WINDOW_SIZE 4096
+#define BLOCK_SIZE 8
+
+// Nothing deflates by more than this, so a bigger ISIZE means a bogus trailer
+#define MAX_DEFLATE_RATIO 1032
+
+namespace libol {
+    struct ChunkDecoder::State {
+        Blowfish::KeySchedule key;
+        z_stream stream;
+        uint8_t input[INPUT_WINDOW_SIZE];
+        uint8_t output[OUTPUT_WINDOW_SIZE];
+
+        // only set for the builtin backend
+        std::unique_ptr<Inflate::Decompressor> decompressor;
+
+        explicit State(ByteSpan key) : key(key.data, key.size) {
+            stream.next_in = Z_NULL;
+            stream.avail_in = 0;
+            stream.zalloc = Z_NULL;
+            stream.zfree = Z_NULL;
+            stream.opaque = Z_NULL;
+
+            if (inflateInit2(&stream, (16 + MAX_WBITS)) != Z_OK) {
+                throw std::runtime_error("zlib: inflateInit2 not Z_OK");
+            }
+        }
+
+        // however the session lets go of it: destruction or being moved over
+        ~State() {
+            inflateEnd(&stream);
+        }
+    };
+
+    ChunkDecoder::ChunkDecoder(ByteSpan key, Inflate::Backend::Id backend, bool trusted) : state(new State(key)) {
+        if (backend != Inflate::Backend::Zlib) {
+            state->decompressor = Inflate::createDecompressor(backend, trusted);
+        }
+    }
+
+    ChunkDecoder::ChunkDecoder(ChunkDecoder&& other) = default;
+    ChunkDecoder& ChunkDecoder::operator=(ChunkDecoder&& other) = default;
+    ChunkDecoder::~ChunkDecoder() = default;
+
+    // Decrypts the chunk one input window at a time and inflates each window
+    // as soon as it's ready. makeRoom(stream) is called whenever inflate has
+    // filled its output and must point next_out/avail_out at more space.
+    template<class MakeRoom>
+    void ChunkDecoder::run(ByteSpan chunk, MakeRoom makeRoom) {
+        if (chunk.size % BLOCK_SIZE != 0) {
+            throw std::invalid_argument("The chunk isn't a whole number of blocks");
+        }
+
+        z_stream& stream = state->stream;
+        if (inflateReset(&stream) != Z_OK) {
+            throw std::runtime_error("zlib: inflateReset not Z_OK");
+        }
+        stream.next_in = Z_NULL;
+        stream.avail_in = 0;
+        stream.next_out = Z_NULL;
+        stream.avail_out = 0;
+
+        size_t decrypted = 0;
+        while (true) {
+            if (stream.avail_in == 0 && decrypted < chunk.size) {
+                size_t length = std::min<size_t>(INPUT_WINDOW_SIZE, chunk.size - decrypted);
+                Blowfish::rawDecrypt(chunk.data + decrypted, state->input, length, state->key);
+                decrypted += length;
+
+                // the last block carries the padding
+                if (decrypted == chunk.size) {
+                    length = Blowfish::unpaddedLength(state->input, length);
+                }
+
+                stream.next_in = state->input;
+                stream.avail_in = length;
+            }
+
+            if (stream.avail_out == 0) {
+                makeRoom(stream);
+            }
+
+            int err = inflate(&stream, Z_NO_FLUSH);
+            if (err == Z_STREAM_END) {
+                break;
+            }
+            // Z_BUF_ERROR just means inflate has run out of input or output to work with
+            bool starved = err == Z_BUF_ERROR && (stream.avail_out == 0 || decrypted < chunk.size);
+            if (err != Z_OK && !starved) {
+                throw std::runtime_error("zlib: inflate not Z_OK");
+            }
+        }
+    }
+
+    // Single-shot path for the builtin backend: decrypts the whole chunk, then
+    // inflates it straight into out. Returns false if the chunk has to go
+    // through zlib instead, because its length isn't known or doesn't fit.
+    bool ChunkDecoder::decodeWhole(ByteSpan chunk, uint8_t* out, size_t capacity, size_t& length) {
+        if (!state->decompressor || peekDecodedLength(chunk) == 0) {
+            return false;
+        }
+
+        std::vector<uint8_t> plaintext = BufferPool::acquire(chunk.size);
+        plaintext.resize(chunk.size);
+        size_t plaintextLength = Blowfish::decrypt(chunk.data, chunk.size, plaintext.data(), state->key);
+
+        bool done = true;
+        try {
+            length = state->decompressor->decompress(ByteSpan(plaintext.data(), plaintextLength), out, capacity);
+        } catch (const std::length_error&) {
+            done = false;
+        }
+        BufferPool::release(std::move(plaintext));
+        return done;
+    }
+
+    size_t ChunkDecoder::peekDecodedLength(ByteSpan chunk) {
+        // the padding is at most one block, so ISIZE is within the last two
+        if (chunk.size < 2 * BLOCK_SIZE || chunk.size % BLOCK_SIZE != 0) {
+            return 0;
+        }
+
+        uint8_t tail[2 * BLOCK_SIZE];
+        Blowfish::rawDecrypt(chunk.data + chunk.size - sizeof(tail), tail, sizeof(tail), state->key);
+        uint8_t padding = tail[sizeof(tail) - 1];
+        if (padding == 0 || padding > BLOCK_SIZE) {
+            return 0;
+        }
+
+        // little-endian, modulo 2^32
+        const uint8_t* isize = tail + sizeof(tail) - padding - 4;
+        uint32_t length = isize[0] | (isize[1] << 8) | (isize[2] << 16) | ((uint32_t) isize[3] << 24);
+        if (length / MAX_DEFLATE_RATIO > chunk.size) {
+            return 0;
+        }
+        return length;
+    }
+
+    std::vector<uint8_t> ChunkDecoder::decode(ByteSpan chunk) {
+        // one spare byte lets inflate see the end of the stream without running out of room;
+        // if the trailer lied (or there's no trailer) the buffer just grows as before
+        size_t length = peekDecodedLength(chunk);
+        size_t initial = length > 0 ? length + 1 : std::max<size_t>(chunk.size, OUTPUT_WINDOW_SIZE);
+        std::vector<uint8_t> decompressed = BufferPool::acquire(initial);
+
+        size_t whole;
+        if (length > 0 && state->decompressor) {
+            decompressed.resize(length);
+            if (decodeWhole(chunk, decompressed.data(), length, whole)) {
+                decompressed.resize(whole);
+                return decompressed;
+            }
+            decompressed.clear();
+        }
+
+        run(chunk, [&] (z_stream& stream) {
+            // If total_out has reached decompressed's size, make room for more
+            if (stream.total_out >= decompressed.size()) {
+                decompressed.resize(decompressed.empty() ? initial : decompressed.size() + (decompressed.size() << 1));
+            }
+            stream.next_out = (Bytef *)(decompressed.data() + stream.total_out);
+            stream.avail_out = decompressed.size() - stream.total_out;
+        });
+
+        decompressed.resize(state->stream.total_out);
+        return decompressed;
+    }
+
+    size_t ChunkDecoder::decode(ByteSpan chunk, uint8_t* out, size_t capacity) {
+        size_t whole;
+        if (decodeWhole(chunk, out, capacity, whole)) {
+            return whole;
+        }
+
+        uint8_t overflow;
+
+        run(chunk, [&] (z_stream& stream) {
+            if (stream.next_out == Z_NULL) {
+                stream.next_out = out;
+                stream.avail_out = capacity;
+            }
+            if (stream.avail_out == 0) {
+                // the output might end exactly at capacity, so let inflate finish
+                // into a spare byte and only complain if it actually writes there
+                if (stream.total_out > capacity) {
+                    throw std::length_error("ChunkDecoder: chunk doesn't fit the output buffer");
+                }
+                stream.next_out = &overflow;
+                stream.avail_out = 1;
+            }
+        });
+
+        if (state->stream.total_out > capacity) {
+            throw std::length_error("ChunkDecoder: chunk doesn't fit the output buffer");
+        }
+        return state->stream.total_out;
+    }
+
+    void ChunkDecoder::decode(ByteSpan chunk, const Sink& sink) {
+        uint8_t* output = state->output;
+
+        run(chunk, [&] (z_stream& stream) {
+            if (stream.next_out != Z_NULL) {
+                sink(output, OUTPUT_WINDOW_SIZE);
+            }
+            stream.next_out = output;
+            stream.avail_out = OUTPUT_WINDOW_SIZE;
+        });
+
+        z_stream& stream = state->stream;
+        size_t pending = OUTPUT_WINDOW_SIZE - stream.avail_out;
+        if (stream.next_out != Z_NULL && pending > 0) {
+            sink(output, pending);
+        }
+    }
+}
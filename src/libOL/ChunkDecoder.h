@@ -0,0 +1,79 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__ChunkDecoder__
+#define __libol__ChunkDecoder__
+
+#include "ByteSpan.h"
+#include "Inflate/Inflate.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace libol {
+    // Decoding session for the chunks of one replay. The Blowfish key schedule
+    // and the zlib inflate state are set up once and reused for every chunk,
+    // so decoding a chunk only costs the decrypt and the inflate themselves.
+    // A session isn't thread-safe; use one per thread. Movable, not copyable.
+    //
+    // Decryption and inflation are fused: the ciphertext is decrypted a small
+    // window at a time straight into inflate's input, so apart from the
+    // output the session only ever holds a few KB of plaintext.
+    //
+    // With the builtin inflate backend, chunks whose decoded length is known
+    // from their trailer are instead decrypted whole and inflated in one shot;
+    // anything else still goes through zlib.
+    class ChunkDecoder {
+        struct State;
+        std::unique_ptr<State> state;
+
+        template<class MakeRoom>
+        void run(ByteSpan chunk, MakeRoom makeRoom);
+        bool decodeWhole(ByteSpan chunk, uint8_t* out, size_t capacity, size_t& length);
+
+    public:
+        typedef std::function<void (const uint8_t* data, size_t length)> Sink;
+
+        /**
+         * \param key the decoded chunk key, see PayloadHeader::getDecodedEncryptionKey
+         * \param trusted skip CRC-32 checks in the builtin backend
+         * \throws std::runtime_error if zlib can't be initialised
+         */
+        explicit ChunkDecoder(ByteSpan key, Inflate::Backend::Id backend = Inflate::getDefaultBackend(), bool trusted = false);
+        explicit ChunkDecoder(const std::vector<uint8_t>& key, Inflate::Backend::Id backend = Inflate::getDefaultBackend(), bool trusted = false)
+            : ChunkDecoder(ByteSpan(key.data(), key.size()), backend, trusted) {}
+        ChunkDecoder(ChunkDecoder&& other);
+        ChunkDecoder& operator=(ChunkDecoder&& other);
+        ~ChunkDecoder();
+
+        /**
+         * Decoded length as recorded in the chunk's gzip trailer (ISIZE), or 0
+         * if it can't be read or isn't plausible. Only decrypts the last two blocks.
+         */
+        size_t peekDecodedLength(ByteSpan chunk);
+
+        /**
+         * The result is sized from peekDecodedLength and comes from the
+         * thread's BufferPool; hand it back with BufferPool::release when done.
+         * \throws std::invalid_argument if the padding is invalid
+         * \throws std::runtime_error if the chunk doesn't inflate
+         */
+        std::vector<uint8_t> decode(ByteSpan chunk);
+        std::vector<uint8_t> decode(const std::vector<uint8_t>& chunk) {
+            return decode(ByteSpan(chunk.data(), chunk.size()));
+        }
+
+        /**
+         * Decodes into a caller-supplied buffer and returns the decoded length
+         * \throws std::length_error if the chunk decodes to more than capacity bytes
+         */
+        size_t decode(ByteSpan chunk, uint8_t* out, size_t capacity);
+
+        // Hands the decoded chunk to sink a few KB at a time, in order
+        void decode(ByteSpan chunk, const Sink& sink);
+    };
+}
+
+#endif /* defined(__libol__ChunkDecoder__) */
@@ -2,30 +2,58 @@
 // Distributed under the MIT License.
 
 #include "ChunkHeader.h"
+#include "ByteSource.h"
 
 #include <fstream>
 
 namespace libol {
-
-    inline void decodeInPlace(std::ifstream& ifs, ChunkHeader& header) {
-        ifs.read(reinterpret_cast<char *>(&header.chunkId), sizeof(header.chunkId));
-        ifs.read(reinterpret_cast<char *>(&header.chunkType), sizeof(header.chunkType));
-        ifs.read(reinterpret_cast<char *>(&header.chunkLength), sizeof(header.chunkLength));
-        ifs.read(reinterpret_cast<char *>(&header.nextChunkId), sizeof(header.nextChunkId));
-        ifs.read(reinterpret_cast<char *>(&header.offset), sizeof(header.offset));
+    template<class Source>
+    ChunkHeader ChunkHeader::decode(Source& source) {
+        MemorySource record(source.readSpan(ROFL_CHUNK_HEADER_LENGTH));
+        ChunkHeader chunkHeader;
+        record.read(&chunkHeader.chunkId);
+        record.read(&chunkHeader.chunkType);
+        record.read(&chunkHeader.chunkLength);
+        record.read(&chunkHeader.nextChunkId);
+        record.read(&chunkHeader.offset);
+        return chunkHeader;
     }
 
-    std::vector<ChunkHeader> ChunkHeader::decodeMultiple(std::ifstream& ifs, int count) {
-        auto headers = std::vector<ChunkHeader>(count);
+    template<class Source>
+    std::vector<ChunkHeader> ChunkHeader::decodeMultiple(Source& source, int count) {
+        std::vector<ChunkHeader> headers;
+        headers.reserve(count);
         for (int i = 0; i < count; i++) {
-            libol::decodeInPlace(ifs, headers[i]);
+            headers.push_back(decode(source));
         }
         return headers;
     }
 
+#define INSTANTIATE(Source) \
+    template ChunkHeader ChunkHeader::decode<Source>(Source&); \
+    template std::vector<ChunkHeader> ChunkHeader::decodeMultiple<Source>(Source&, int);
+    LIBOL_FOR_EACH_BYTE_SOURCE(INSTANTIATE)
+#undef INSTANTIATE
+
+    std::vector<ChunkHeader> ChunkHeader::decodeMultiple(std::ifstream& ifs, int count) {
+        REQUIRE(count >= 0);
+        std::vector<uint8_t> records((size_t) count * ROFL_CHUNK_HEADER_LENGTH);
+        readFromStream(ifs, records.data(), records.size());
+        MemorySource source(ByteSpan(records.data(), records.size()));
+        return decodeMultiple(source, count);
+    }
+
     ChunkHeader ChunkHeader::decode(std::ifstream& ifs) {
-        ChunkHeader chunkHeader;
-        libol::decodeInPlace(ifs, chunkHeader);
+        uint8_t record[ROFL_CHUNK_HEADER_LENGTH];
+        readFromStream(ifs, record, sizeof(record));
+        MemorySource source(ByteSpan(record, sizeof(record)));
+        return decode(source);
+    }
+
+    ChunkHeader ChunkHeader::decode(const uint8_t* buf, size_t& pos, size_t len) {
+        MemorySource source(ByteSpan(buf, len), pos);
+        ChunkHeader chunkHeader = decode(source);
+        pos = source.tell();
         return chunkHeader;
     }
 }
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include <iostream>
 #include <vector>
 
+#define ROFL_CHUNK_HEADER_LENGTH 17
+#define ROFL_KEYFRAME_HEADER_LENGTH 17
+
 namespace libol {
     class ChunkHeader {
     public:
@@ -17,8 +20,15 @@ namespace libol {
         int32_t nextChunkId;
         int32_t offset;
 
+        // Reads the whole record at once, see ByteSource.h
+        template<class Source>
+        static ChunkHeader decode(Source& source);
+        template<class Source>
+        static std::vector<ChunkHeader> decodeMultiple(Source& source, int count);
+
         static std::vector<ChunkHeader> decodeMultiple(std::ifstream& ifs, int count);
         static ChunkHeader decode(std::ifstream& ifs);
+        static ChunkHeader decode(const uint8_t* buf, size_t& pos, size_t len);
     };
 }
 
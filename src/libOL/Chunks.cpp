@@ -3,57 +3,69 @@
 
 #include "Chunks.h"
 
-#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
 
-extern "C" {
-#include <zlib.h>
-}
-
-#include "Blowfish/Blowfish.h"
+#include "ChunkDecoder.h"
+#include "Parallel.h"
 
 namespace libol {
     namespace Chunks {
-        std::vector<uint8_t> decryptAndDecompress(std::vector<uint8_t> bytes, std::vector<uint8_t> key) {
-            auto decrypted = Blowfish::decrypt(bytes, key);
+        std::vector<uint8_t> decryptAndDecompress(ByteSpan bytes, ByteSpan key) {
+            ChunkDecoder decoder(key);
+            return decoder.decode(bytes);
+        }
 
-            std::vector<uint8_t> decompressed;
-            decompressed.resize(decrypted.size());
+        std::vector<uint8_t> decryptAndDecompress(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key) {
+            return decryptAndDecompress(ByteSpan(bytes.data(), bytes.size()), ByteSpan(key.data(), key.size()));
+        }
 
-            z_stream stream;
-            stream.next_in = (Bytef *)decrypted.data();
-            stream.avail_in = decrypted.size();
-            stream.total_out = 0;
-            stream.zalloc = Z_NULL;
-            stream.zfree = Z_NULL;  
+        size_t decryptAndDecompress(ByteSpan bytes, ByteSpan key, uint8_t* out, size_t capacity) {
+            ChunkDecoder decoder(key);
+            return decoder.decode(bytes, out, capacity);
+        }
 
-            if (inflateInit2(&stream, (16 + MAX_WBITS)) != Z_OK) {
-                throw std::runtime_error("zlib: inflateInit2 not Z_OK");
-            }
+        std::vector<DecryptedChunk> decryptAndDecompressParallel(std::vector<EncryptedChunk> chunks, const std::vector<uint8_t>& key, unsigned threadCount) {
+            std::sort(chunks.begin(), chunks.end(), [] (const EncryptedChunk& a, const EncryptedChunk& b) {
+                return a.chunkId < b.chunkId;
+            });
 
-            bool done = false;
-            while (!done) {
-                // If total_out has reached decompressed's capacity, make room for more
-                if (stream.total_out >= decompressed.capacity()) {
-                    // Resize output to 150% of previous size
-                    decompressed.resize(decompressed.capacity() + (decompressed.capacity() << 1));
-                }
+            std::vector<DecryptedChunk> result(chunks.size());
+            threadCount = Parallel::getThreadCount(threadCount, chunks.size());
+
+            // workers pull the next chunk index until none are left
+            std::atomic<size_t> next(0);
+            std::atomic<bool> failed(false);
+            std::exception_ptr error;
+            std::mutex errorMutex;
 
-                stream.next_out = (Bytef *)(&decompressed[0] + stream.total_out);
-                stream.avail_out = decompressed.capacity() - stream.total_out;
-                int err = inflate(&stream, Z_SYNC_FLUSH);
-                if (err == Z_STREAM_END) {
-                    done = true;
-                } else if (err != Z_OK)  {
-                    throw std::runtime_error("zlib: inflate not Z_OK");
+            auto work = [&] () {
+                try {
+                    // one session per worker, reused for every chunk it picks up
+                    ChunkDecoder decoder(key);
+                    size_t i;
+                    while (!failed && (i = next++) < chunks.size()) {
+                        result[i].chunkId = chunks[i].chunkId;
+                        result[i].bytes = decoder.decode(chunks[i].bytes);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed = true;
                 }
-            }
+            };
 
-            if (inflateEnd(&stream) != Z_OK) {
-                throw std::runtime_error("zlib: inflateEnd not Z_OK");
-            }  
+            Parallel::run(threadCount, failed, work);
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
 
-            decompressed.resize(stream.total_out);
-            return decompressed;
+            return result;
         }
     }
 }
@@ -4,12 +4,40 @@
 #ifndef __libol__Chunks__
 #define __libol__Chunks__
 
+#include "ByteSpan.h"
+
 #include <cstdint>
 #include <vector>
 
 namespace libol {
     namespace Chunks {
-        std::vector<uint8_t> decryptAndDecompress(std::vector<uint8_t> bytes, std::vector<uint8_t> key);
+        struct EncryptedChunk {
+            int32_t chunkId;
+            ByteSpan bytes;
+        };
+
+        struct DecryptedChunk {
+            int32_t chunkId;
+            std::vector<uint8_t> bytes;
+        };
+
+        // One-off decode of a single chunk; use a ChunkDecoder for more than one
+        std::vector<uint8_t> decryptAndDecompress(ByteSpan bytes, ByteSpan key);
+        std::vector<uint8_t> decryptAndDecompress(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& key);
+
+        /**
+         * Decodes into a caller-supplied buffer and returns the decoded length
+         * \throws std::length_error if the chunk decodes to more than capacity bytes
+         */
+        size_t decryptAndDecompress(ByteSpan bytes, ByteSpan key, uint8_t* out, size_t capacity);
+
+        /**
+         * Decrypts and decompresses independent chunks on threadCount worker
+         * threads (0 picks one per hardware thread). Results are returned in
+         * chunk id order; the first exception thrown by a worker is rethrown
+         * here once all workers have stopped.
+         */
+        std::vector<DecryptedChunk> decryptAndDecompressParallel(std::vector<EncryptedChunk> chunks, const std::vector<uint8_t>& key, unsigned threadCount = 0);
     }
 }
 
@@ -7,27 +7,38 @@
 #include "Block.h"
 #include "Value.h"
 
+#include <array>
 #include <cstdint>
-#include <map>
-#include <string>
-#include <functional>
+#include <type_traits>
 
 namespace libol {
     class EntityAttribute {
-        typedef std::pair<uint8_t, uint8_t> AttrId;
+    public:
+        // One attribute as read from an AttributeGroup update
+        struct Attribute {
+            const char* name;
+            bool isByte; // read as a uint8_t rather than a float
+            float value;
+        };
 
-        std::map<AttrId, std::function< void (Object&, Block::Stream&) >> attributes;
+    private:
+        struct Definition {
+            const char* name;
+            bool isByte;
+        };
 
-        template<typename T>
-        void defineAttribute(uint8_t groupBit, uint8_t attrBit, std::string name) {
-            AttrId id {groupBit, attrBit};
+        // Indexed by (groupBit - 1) * 32 + (attrBit - 1); name is null for unknown attributes
+        std::array<Definition, 8 * 32> attributes;
 
-            attributes[id] = [name] (Object& obj, Block::Stream& stream) {
-                obj.setv(name, stream.read<T>());
-            };
+        template<typename T>
+        void defineAttribute(uint8_t groupBit, uint8_t attrBit, const char* name) {
+            static_assert(std::is_same<T, float>::value || std::is_same<T, uint8_t>::value, "attributes are floats or bytes");
+            attributes[(groupBit - 1) * 32 + (attrBit - 1)] = Definition({name, std::is_same<T, uint8_t>::value});
         }
 
         EntityAttribute() {
+            attributes.fill(Definition({nullptr, false}));
+
             // Group 1
             defineAttribute<float>(1, 1, "CurrentGold");
             defineAttribute<float>(1, 2, "TotalGold");
@@ -68,19 +79,29 @@ namespace libol {
             defineAttribute<uint8_t>(4, 15, "Level");
         }
     public:
-        static bool read(Object* obj, Block::Stream& stream, uint8_t groupBit, uint8_t attrBit) {
-            static EntityAttribute reader;
-            AttrId id {groupBit + 1, attrBit + 1};
+        // groupBit and attrBit count from 0, as in the masks
+        static bool read(Attribute* attr, Block::Stream& stream, uint8_t groupBit, uint8_t attrBit) {
+            static const EntityAttribute reader;
 
-            if(!reader.attributes.count(id)) return false;
+            const Definition& definition = reader.attributes[groupBit * 32 + attrBit];
+            if(!definition.name) return false;
             try {
-                reader.attributes[id](*obj, stream);
+                attr->name = definition.name;
+                attr->isByte = definition.isByte;
+                attr->value = definition.isByte ? stream.read<uint8_t>() : stream.read<float>();
             } catch(...) {
                 // TODO: investigate, minions have different mask?
                 return false;
             }
             return true;
         }
+
+        static void set(Object& obj, const Attribute& attr) {
+            if(attr.isByte)
+                obj.setv(attr.name, (uint8_t) attr.value);
+            else
+                obj.setv(attr.name, attr.value);
+        }
     };
 }
 
@@ -2,21 +2,42 @@
 // Distributed under the MIT License.
 
 #include "Header.h"
+#include "ByteSource.h"
 
 #include <fstream>
 
 namespace libol {
-    Header Header::decode(std::ifstream& ifs) {
+    template<class Source>
+    Header Header::decode(Source& source) {
+        MemorySource record(source.readSpan(ROFL_HEADER_LENGTH));
         Header header;
-        ifs.read(reinterpret_cast<char *>(header.magic.data()), header.magic.size());
-        ifs.read(reinterpret_cast<char *>(header.signature.data()), header.signature.size());
-        ifs.read(reinterpret_cast<char *>(&header.headerlength), sizeof(header.headerlength));
-        ifs.read(reinterpret_cast<char *>(&header.fileLength), sizeof(header.fileLength));
-        ifs.read(reinterpret_cast<char *>(&header.metadataOffset), sizeof(header.metadataOffset));
-        ifs.read(reinterpret_cast<char *>(&header.metadataLength), sizeof(header.metadataLength));
-        ifs.read(reinterpret_cast<char *>(&header.payloadHeaderOffset), sizeof(header.payloadHeaderOffset));
-        ifs.read(reinterpret_cast<char *>(&header.payloadHeaderLength), sizeof(header.payloadHeaderLength));
-        ifs.read(reinterpret_cast<char *>(&header.payloadOffset), sizeof(header.payloadOffset));
+        record.read(header.magic.data(), header.magic.size());
+        record.read(header.signature.data(), header.signature.size());
+        record.read(&header.headerlength);
+        record.read(&header.fileLength);
+        record.read(&header.metadataOffset);
+        record.read(&header.metadataLength);
+        record.read(&header.payloadHeaderOffset);
+        record.read(&header.payloadHeaderLength);
+        record.read(&header.payloadOffset);
+        return header;
+    }
+
+#define INSTANTIATE(Source) template Header Header::decode<Source>(Source&);
+    LIBOL_FOR_EACH_BYTE_SOURCE(INSTANTIATE)
+#undef INSTANTIATE
+
+    Header Header::decode(std::ifstream& ifs) {
+        uint8_t record[ROFL_HEADER_LENGTH];
+        readFromStream(ifs, record, sizeof(record));
+        MemorySource source(ByteSpan(record, sizeof(record)));
+        return decode(source);
+    }
+
+    Header Header::decode(const uint8_t* buf, size_t& pos, size_t len) {
+        MemorySource source(ByteSpan(buf, len), pos);
+        Header header = decode(source);
+        pos = source.tell();
         return header;
     }
 }
\ No newline at end of file
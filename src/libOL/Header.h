@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <iostream>
 
+#define ROFL_HEADER_LENGTH 288
+
 namespace libol {
     class Header {
     public:
@@ -21,7 +23,12 @@ namespace libol {
         uint32_t payloadHeaderLength;
         uint32_t payloadOffset;
 
+        // Reads the whole record at once, see ByteSource.h
+        template<class Source>
+        static Header decode(Source& source);
+
         static Header decode(std::ifstream& ifs);
+        static Header decode(const uint8_t* buf, size_t& pos, size_t len);
     };
 }
 
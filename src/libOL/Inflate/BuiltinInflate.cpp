@@ -0,0 +1,553 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "BuiltinInflate.h"
+
+#include <cstring>
+#include <stdexcept>
+
+extern "C" {
+#include <zlib.h>
+}
+
+#define LITLEN_TABLE_BITS 10
+#define DIST_TABLE_BITS 8
+#define PRECODE_TABLE_BITS 7
+#define MAX_CODE_LENGTH 15
+
+#define LITLEN_SYMBOLS 288
+#define DIST_SYMBOLS 32
+#define PRECODE_SYMBOLS 19
+
+// How far past the end of the input the bit reader may pretend to read zeros
+// before giving up; real overreads are caught when the trailer is located.
+#define MAX_OVERREAD_BYTES 16
+
+/* Table entries
+ * bits 0-7   number of bits to consume for this entry
+ * bits 8-11  extra bits that follow the code (lengths, distances), or the
+ *            size in bits of the subtable a root entry points to
+ * bits 12-15 entry kind
+ * bits 16-31 literal byte, length/distance base, or subtable offset
+ */
+#define ENTRY_INVALID  0x1000
+#define ENTRY_END      0x2000
+#define ENTRY_SUBTABLE 0x4000
+#define ENTRY_LITERAL  0x8000
+
+static inline uint32_t makeEntry(uint32_t kind, uint32_t extra, uint32_t value) {
+    return (value << 16) | kind | (extra << 8);
+}
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t precodeOrder[PRECODE_SYMBOLS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+static std::runtime_error corrupt(const char* what) {
+    return std::runtime_error(std::string("inflate: ") + what);
+}
+
+// What each symbol decodes to, minus the code length
+struct SymbolEntries {
+    uint32_t litlen[LITLEN_SYMBOLS];
+    uint32_t dist[DIST_SYMBOLS];
+    uint32_t precode[PRECODE_SYMBOLS];
+
+    SymbolEntries() {
+        for (uint32_t sym = 0; sym < LITLEN_SYMBOLS; sym++) {
+            if (sym < 256) {
+                litlen[sym] = makeEntry(ENTRY_LITERAL, 0, sym);
+            } else if (sym == 256) {
+                litlen[sym] = makeEntry(ENTRY_END, 0, 0);
+            } else if (sym < 257 + 29) {
+                litlen[sym] = makeEntry(0, lengthExtra[sym - 257], lengthBase[sym - 257]);
+            } else {
+                litlen[sym] = makeEntry(ENTRY_INVALID, 0, 0);
+            }
+        }
+        for (uint32_t sym = 0; sym < DIST_SYMBOLS; sym++) {
+            dist[sym] = sym < 30 ? makeEntry(0, distExtra[sym], distBase[sym]) : makeEntry(ENTRY_INVALID, 0, 0);
+        }
+        for (uint32_t sym = 0; sym < PRECODE_SYMBOLS; sym++) {
+            precode[sym] = makeEntry(0, 0, sym);
+        }
+    }
+};
+
+static const SymbolEntries& getSymbolEntries() {
+    static const SymbolEntries entries;
+    return entries;
+}
+
+/**
+ * Builds a two-level decode table for a canonical Huffman code, in the same
+ * layout as zlib's inflate_table: codes up to tableBits long are replicated
+ * through the root table, longer ones go to subtables sized for the codes
+ * that share their root prefix. Incomplete codes are allowed; the unused
+ * entries decode as invalid.
+ */
+static void buildTable(uint32_t* table, size_t capacity, unsigned tableBits,
+                       const uint8_t* lengths, unsigned symbolCount, const uint32_t* symbolEntries) {
+    unsigned count[MAX_CODE_LENGTH + 1] = {0};
+    for (unsigned sym = 0; sym < symbolCount; sym++) {
+        count[lengths[sym]]++;
+    }
+    count[0] = 0;
+
+    unsigned maxLength = MAX_CODE_LENGTH;
+    while (maxLength > 0 && count[maxLength] == 0) {
+        maxLength--;
+    }
+
+    size_t rootSize = (size_t) 1 << tableBits;
+    for (size_t i = 0; i < rootSize; i++) {
+        table[i] = makeEntry(ENTRY_INVALID, 0, 0) | tableBits;
+    }
+    if (maxLength == 0) {
+        // no codes at all, e.g. a block without matches has no distance codes
+        return;
+    }
+
+    int left = 1;
+    for (unsigned length = 1; length <= MAX_CODE_LENGTH; length++) {
+        left = (left << 1) - count[length];
+        if (left < 0) {
+            throw corrupt("over-subscribed Huffman code");
+        }
+    }
+
+    // symbols sorted by code length, then by value
+    unsigned offsets[MAX_CODE_LENGTH + 2];
+    offsets[1] = 0;
+    for (unsigned length = 1; length <= MAX_CODE_LENGTH; length++) {
+        offsets[length + 1] = offsets[length] + count[length];
+    }
+    uint16_t sorted[LITLEN_SYMBOLS];
+    for (unsigned sym = 0; sym < symbolCount; sym++) {
+        if (lengths[sym] != 0) {
+            sorted[offsets[lengths[sym]]++] = sym;
+        }
+    }
+    unsigned total = offsets[MAX_CODE_LENGTH + 1];
+
+    unsigned remaining[MAX_CODE_LENGTH + 1];
+    memcpy(remaining, count, sizeof(remaining));
+
+    size_t nextSubtable = rootSize;
+    size_t subtableStart = 0;
+    unsigned subtableBits = 0;
+    uint32_t currentPrefix = ~0u;
+
+    uint32_t code = 0;
+    unsigned codeLength = lengths[sorted[0]];
+    for (unsigned i = 0; i < total; i++) {
+        unsigned sym = sorted[i];
+        unsigned length = lengths[sym];
+        code <<= length - codeLength;
+        codeLength = length;
+
+        // DEFLATE sends codes starting from the most significant bit, the bit reader hands out the least significant first
+        uint32_t reversed = 0;
+        for (unsigned bit = 0; bit < length; bit++) {
+            reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        }
+
+        if (length <= tableBits) {
+            uint32_t entry = symbolEntries[sym] | length;
+            for (size_t j = reversed; j < rootSize; j += (size_t) 1 << length) {
+                table[j] = entry;
+            }
+        } else {
+            uint32_t prefix = reversed & (rootSize - 1);
+            if (prefix != currentPrefix) {
+                // make the subtable just big enough for the codes left under this prefix
+                unsigned bits = length - tableBits;
+                int slots = 1 << bits;
+                while (bits + tableBits < maxLength) {
+                    slots -= remaining[bits + tableBits];
+                    if (slots <= 0) {
+                        break;
+                    }
+                    bits++;
+                    slots <<= 1;
+                }
+
+                subtableBits = bits;
+                subtableStart = nextSubtable;
+                nextSubtable += (size_t) 1 << subtableBits;
+                if (nextSubtable > capacity) {
+                    throw corrupt("Huffman table overflow");
+                }
+                for (size_t j = subtableStart; j < nextSubtable; j++) {
+                    table[j] = makeEntry(ENTRY_INVALID, 0, 0) | subtableBits;
+                }
+
+                table[prefix] = makeEntry(ENTRY_SUBTABLE, subtableBits, subtableStart) | tableBits;
+                currentPrefix = prefix;
+            }
+
+            unsigned subLength = length - tableBits;
+            uint32_t entry = symbolEntries[sym] | subLength;
+            for (size_t j = reversed >> tableBits; j < ((size_t) 1 << subtableBits); j += (size_t) 1 << subLength) {
+                table[subtableStart + j] = entry;
+            }
+        }
+
+        remaining[length]--;
+        code++;
+    }
+}
+
+namespace libol {
+    namespace Inflate {
+        // Least-significant-bit-first reader over an in-memory buffer. Past the
+        // end it supplies zero bytes, which is harmless as long as the decoder
+        // doesn't actually consume them; tell() exposes it if it did.
+        struct BuiltinDecompressor::BitReader {
+            const uint8_t* start;
+            const uint8_t* next;
+            const uint8_t* end;
+            uint64_t buffer;
+            unsigned count;
+            size_t overread;
+
+            BitReader(ByteSpan in) : start(in.data), next(in.data), end(in.data + in.size), buffer(0), count(0), overread(0) {}
+
+            // Tops the buffer up to at least 56 bits
+            inline void refill() {
+                if (count >= 56) {
+                    return;
+                }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                if (end - next >= 8) {
+                    // whole word at once; the bits above count are the next input bits, so loading them again later is harmless
+                    uint64_t word;
+                    memcpy(&word, next, sizeof(word));
+                    buffer |= word << count;
+                    next += (63 - count) >> 3;
+                    count |= 56;
+                    return;
+                }
+#endif
+                while (count <= 56) {
+                    uint64_t byte;
+                    if (next < end) {
+                        byte = *next++;
+                    } else {
+                        if (++overread > MAX_OVERREAD_BYTES) {
+                            throw corrupt("unexpected end of input");
+                        }
+                        byte = 0;
+                    }
+                    buffer |= byte << count;
+                    count += 8;
+                }
+            }
+
+            inline uint32_t peek(unsigned bits) const {
+                return (uint32_t) (buffer & (((uint64_t) 1 << bits) - 1));
+            }
+
+            inline void consume(unsigned bits) {
+                buffer >>= bits;
+                count -= bits;
+            }
+
+            inline uint32_t read(unsigned bits) {
+                uint32_t value = peek(bits);
+                consume(bits);
+                return value;
+            }
+
+            // Drops the bits left in the current byte and returns the offset of the next byte
+            size_t alignToByte() {
+                consume(count & 7);
+                size_t position = (next - start) + overread - (count >> 3);
+                if (position > (size_t) (end - start)) {
+                    throw corrupt("unexpected end of input");
+                }
+                next = start + position;
+                buffer = 0;
+                count = 0;
+                overread = 0;
+                return position;
+            }
+        };
+
+        BuiltinDecompressor::BuiltinDecompressor(bool trusted) : verifyChecksum(!trusted) {
+            const SymbolEntries& entries = getSymbolEntries();
+
+            uint8_t lengths[LITLEN_SYMBOLS];
+            for (unsigned sym = 0; sym < LITLEN_SYMBOLS; sym++) {
+                lengths[sym] = sym < 144 ? 8 : sym < 256 ? 9 : sym < 280 ? 7 : 8;
+            }
+            buildTable(fixedLitlenTable, sizeof(fixedLitlenTable) / sizeof(uint32_t), LITLEN_TABLE_BITS,
+                       lengths, LITLEN_SYMBOLS, entries.litlen);
+
+            for (unsigned sym = 0; sym < DIST_SYMBOLS; sym++) {
+                lengths[sym] = 5;
+            }
+            buildTable(fixedDistTable, sizeof(fixedDistTable) / sizeof(uint32_t), DIST_TABLE_BITS,
+                       lengths, DIST_SYMBOLS, entries.dist);
+        }
+
+        size_t BuiltinDecompressor::decompress(ByteSpan in, uint8_t* out, size_t capacity) {
+            // gzip header, RFC 1952
+            if (in.size < 18 || in[0] != 0x1f || in[1] != 0x8b || in[2] != 8) {
+                throw corrupt("not a gzip member");
+            }
+            uint8_t flags = in[3];
+            if (flags & 0xe0) {
+                throw corrupt("reserved gzip flags set");
+            }
+            size_t pos = 10;
+            if (flags & 0x04) { // FEXTRA
+                if (pos + 2 > in.size) {
+                    throw corrupt("truncated gzip header");
+                }
+                pos += 2 + (in[pos] | (in[pos + 1] << 8));
+            }
+            if (flags & 0x08) { // FNAME
+                while (pos < in.size && in[pos] != 0) {
+                    pos++;
+                }
+                pos++;
+            }
+            if (flags & 0x10) { // FCOMMENT
+                while (pos < in.size && in[pos] != 0) {
+                    pos++;
+                }
+                pos++;
+            }
+            if (flags & 0x02) { // FHCRC
+                pos += 2;
+            }
+            if (pos + 8 > in.size) {
+                throw corrupt("truncated gzip header");
+            }
+
+            BitReader bits(in.subspan(pos, in.size - pos));
+            size_t length = inflateBlocks(bits, out, capacity);
+
+            // trailer: CRC-32 and ISIZE, both little-endian
+            size_t trailer = pos + bits.alignToByte();
+            if (trailer + 8 > in.size) {
+                throw corrupt("truncated gzip trailer");
+            }
+            uint32_t crc, isize;
+            in.read(&crc, trailer);
+            in.read(&isize, trailer + 4);
+            if (isize != (uint32_t) length) {
+                throw corrupt("length doesn't match the gzip trailer");
+            }
+            if (verifyChecksum && crc != (uint32_t) crc32(0, out, length)) {
+                throw corrupt("CRC-32 doesn't match the gzip trailer");
+            }
+
+            return length;
+        }
+
+        size_t BuiltinDecompressor::inflateBlocks(BitReader& bits, uint8_t* out, size_t capacity) {
+            uint8_t* outStart = out;
+            uint8_t* outEnd = out + capacity;
+
+            bool last = false;
+            while (!last) {
+                bits.refill();
+                last = bits.read(1);
+                unsigned type = bits.read(2);
+
+                if (type == 0) {
+                    // stored
+                    size_t pos = bits.alignToByte();
+                    const uint8_t* data = bits.start + pos;
+                    if (bits.end - data < 4) {
+                        throw corrupt("truncated stored block");
+                    }
+                    uint16_t length = data[0] | (data[1] << 8);
+                    uint16_t complement = data[2] | (data[3] << 8);
+                    if ((uint16_t) ~complement != length) {
+                        throw corrupt("stored block length mismatch");
+                    }
+                    data += 4;
+                    if ((size_t) (bits.end - data) < length) {
+                        throw corrupt("truncated stored block");
+                    }
+                    if ((size_t) (outEnd - out) < length) {
+                        throw std::length_error("inflate: output buffer too small");
+                    }
+                    memcpy(out, data, length);
+                    out += length;
+                    bits.next = data + length;
+                } else if (type == 1) {
+                    decodeHuffmanBlock(bits, fixedLitlenTable, fixedDistTable, outStart, out, outEnd);
+                } else if (type == 2) {
+                    readDynamicTables(bits);
+                    decodeHuffmanBlock(bits, litlenTable, distTable, outStart, out, outEnd);
+                } else {
+                    throw corrupt("invalid block type");
+                }
+            }
+
+            return out - outStart;
+        }
+
+        void BuiltinDecompressor::readDynamicTables(BitReader& bits) {
+            const SymbolEntries& entries = getSymbolEntries();
+
+            bits.refill();
+            unsigned litlenCount = bits.read(5) + 257;
+            unsigned distCount = bits.read(5) + 1;
+            unsigned precodeCount = bits.read(4) + 4;
+            if (litlenCount > 286 || distCount > 30) {
+                throw corrupt("too many length or distance codes");
+            }
+
+            uint8_t precodeLengths[PRECODE_SYMBOLS] = {0};
+            for (unsigned i = 0; i < precodeCount; i++) {
+                bits.refill();
+                precodeLengths[precodeOrder[i]] = bits.read(3);
+            }
+            buildTable(precodeTable, sizeof(precodeTable) / sizeof(uint32_t), PRECODE_TABLE_BITS,
+                       precodeLengths, PRECODE_SYMBOLS, entries.precode);
+
+            // literal/length and distance code lengths form one run-length coded sequence
+            uint8_t lengths[LITLEN_SYMBOLS + DIST_SYMBOLS];
+            unsigned total = litlenCount + distCount;
+            unsigned i = 0;
+            while (i < total) {
+                bits.refill();
+                uint32_t entry = precodeTable[bits.peek(PRECODE_TABLE_BITS)];
+                if (entry & ENTRY_INVALID) {
+                    throw corrupt("invalid code length code");
+                }
+                bits.consume(entry & 0xff);
+                unsigned sym = entry >> 16;
+
+                if (sym < 16) {
+                    lengths[i++] = sym;
+                    continue;
+                }
+
+                uint8_t value = 0;
+                unsigned repeat;
+                if (sym == 16) {
+                    if (i == 0) {
+                        throw corrupt("repeat with no previous length");
+                    }
+                    value = lengths[i - 1];
+                    repeat = 3 + bits.read(2);
+                } else if (sym == 17) {
+                    repeat = 3 + bits.read(3);
+                } else {
+                    repeat = 11 + bits.read(7);
+                }
+                if (i + repeat > total) {
+                    throw corrupt("code lengths overrun");
+                }
+                memset(lengths + i, value, repeat);
+                i += repeat;
+            }
+
+            if (lengths[256] == 0) {
+                throw corrupt("no end-of-block code");
+            }
+
+            buildTable(litlenTable, sizeof(litlenTable) / sizeof(uint32_t), LITLEN_TABLE_BITS,
+                       lengths, litlenCount, entries.litlen);
+            buildTable(distTable, sizeof(distTable) / sizeof(uint32_t), DIST_TABLE_BITS,
+                       lengths + litlenCount, distCount, entries.dist);
+        }
+
+        void BuiltinDecompressor::decodeHuffmanBlock(BitReader& bits, const uint32_t* litlen, const uint32_t* dist,
+                                                     uint8_t* outStart, uint8_t*& outRef, uint8_t* outEnd) {
+            uint8_t* out = outRef;
+
+            while (true) {
+                // a literal/length code, its extra bits, a distance code and its extra bits take at most 48 bits,
+                // so runs of literals only refill every few symbols
+                if (bits.count < 48) {
+                    bits.refill();
+                }
+
+                uint32_t entry = litlen[bits.peek(LITLEN_TABLE_BITS)];
+                if (entry & ENTRY_SUBTABLE) {
+                    bits.consume(LITLEN_TABLE_BITS);
+                    entry = litlen[(entry >> 16) + bits.peek((entry >> 8) & 0xf)];
+                }
+                bits.consume(entry & 0xff);
+
+                if (entry & ENTRY_LITERAL) {
+                    if (out == outEnd) {
+                        throw std::length_error("inflate: output buffer too small");
+                    }
+                    *out++ = (uint8_t) (entry >> 16);
+                    continue;
+                }
+                if (entry & ENTRY_END) {
+                    break;
+                }
+                if (entry & ENTRY_INVALID) {
+                    throw corrupt("invalid literal/length code");
+                }
+
+                size_t length = (entry >> 16) + bits.read((entry >> 8) & 0xf);
+
+                entry = dist[bits.peek(DIST_TABLE_BITS)];
+                if (entry & ENTRY_SUBTABLE) {
+                    bits.consume(DIST_TABLE_BITS);
+                    entry = dist[(entry >> 16) + bits.peek((entry >> 8) & 0xf)];
+                }
+                bits.consume(entry & 0xff);
+                if (entry & ENTRY_INVALID) {
+                    throw corrupt("invalid distance code");
+                }
+                size_t distance = (entry >> 16) + bits.read((entry >> 8) & 0xf);
+
+                if (distance > (size_t) (out - outStart)) {
+                    throw corrupt("distance too far back");
+                }
+                if (length > (size_t) (outEnd - out)) {
+                    throw std::length_error("inflate: output buffer too small");
+                }
+
+                const uint8_t* src = out - distance;
+                uint8_t* end = out + length;
+                if (distance >= 8 && outEnd - end >= 8) {
+                    // whole words; may write up to 7 bytes past end, which are overwritten later
+                    while (out < end) {
+                        memcpy(out, src, 8);
+                        out += 8;
+                        src += 8;
+                    }
+                    out = end;
+                } else if (distance == 1) {
+                    memset(out, *src, length);
+                    out = end;
+                } else {
+                    while (out < end) {
+                        *out++ = *src++;
+                    }
+                }
+            }
+
+            outRef = out;
+        }
+    }
+}
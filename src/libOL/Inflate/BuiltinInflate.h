@@ -0,0 +1,42 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__BuiltinInflate__
+#define __libol__BuiltinInflate__
+
+#include "Inflate.h"
+
+namespace libol {
+    namespace Inflate {
+        // Whole-buffer gzip/DEFLATE decoder in the style of libdeflate: a
+        // 64-bit bit buffer refilled a word at a time, table-driven Huffman
+        // decoding with a 2-level lookup, and word-sized match copies. There's
+        // no streaming state, so the whole input and output must be in memory.
+        class BuiltinDecompressor : public Decompressor {
+            // Lookup tables sized for the worst case with the chosen root bits
+            // (see zlib's enough.c): 286 lit/len codes at 10 bits, 30 distance
+            // codes at 8 bits, 19 code length codes at 7 bits.
+            uint32_t litlenTable[1334];
+            uint32_t distTable[402];
+            uint32_t precodeTable[128];
+
+            uint32_t fixedLitlenTable[1334];
+            uint32_t fixedDistTable[402];
+            bool verifyChecksum;
+
+        public:
+            explicit BuiltinDecompressor(bool trusted);
+
+            size_t decompress(ByteSpan in, uint8_t* out, size_t capacity);
+
+        private:
+            struct BitReader;
+            size_t inflateBlocks(BitReader& bits, uint8_t* out, size_t capacity);
+            void readDynamicTables(BitReader& bits);
+            void decodeHuffmanBlock(BitReader& bits, const uint32_t* litlen, const uint32_t* dist,
+                                    uint8_t* outStart, uint8_t*& out, uint8_t* outEnd);
+        };
+    }
+}
+
+#endif /* defined(__libol__BuiltinInflate__) */
@@ -0,0 +1,80 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "Inflate.h"
+#include "BuiltinInflate.h"
+
+#include <atomic>
+#include <stdexcept>
+
+extern "C" {
+#include <zlib.h>
+}
+
+namespace libol {
+    namespace Inflate {
+        class ZlibDecompressor : public Decompressor {
+            z_stream stream;
+
+        public:
+            ZlibDecompressor() {
+                stream.next_in = Z_NULL;
+                stream.avail_in = 0;
+                stream.zalloc = Z_NULL;
+                stream.zfree = Z_NULL;
+                stream.opaque = Z_NULL;
+
+                if (inflateInit2(&stream, (16 + MAX_WBITS)) != Z_OK) {
+                    throw std::runtime_error("zlib: inflateInit2 not Z_OK");
+                }
+            }
+
+            ~ZlibDecompressor() {
+                inflateEnd(&stream);
+            }
+
+            size_t decompress(ByteSpan in, uint8_t* out, size_t capacity) {
+                if (inflateReset(&stream) != Z_OK) {
+                    throw std::runtime_error("zlib: inflateReset not Z_OK");
+                }
+                stream.next_in = (Bytef *) in.data;
+                stream.avail_in = in.size;
+                stream.next_out = out;
+                stream.avail_out = capacity;
+
+                int err = inflate(&stream, Z_FINISH);
+                if (err == Z_STREAM_END) {
+                    return stream.total_out;
+                }
+                if (err == Z_BUF_ERROR && stream.avail_out == 0) {
+                    throw std::length_error("zlib: output buffer too small");
+                }
+                throw std::runtime_error("zlib: inflate not Z_STREAM_END");
+            }
+        };
+
+#ifdef LIBOL_BUILTIN_INFLATE
+        static std::atomic<int> defaultBackend(Backend::Builtin);
+#else
+        static std::atomic<int> defaultBackend(Backend::Zlib);
+#endif
+
+        std::unique_ptr<Decompressor> createDecompressor(Backend::Id backend, bool trusted) {
+            switch (backend) {
+            case Backend::Zlib:
+                return std::unique_ptr<Decompressor>(new ZlibDecompressor);
+            case Backend::Builtin:
+                return std::unique_ptr<Decompressor>(new BuiltinDecompressor(trusted));
+            }
+            throw std::invalid_argument("Unknown inflate backend");
+        }
+
+        Backend::Id getDefaultBackend() {
+            return (Backend::Id) defaultBackend.load();
+        }
+
+        void setDefaultBackend(Backend::Id backend) {
+            defaultBackend.store(backend);
+        }
+    }
+}
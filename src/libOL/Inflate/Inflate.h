@@ -0,0 +1,48 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__Inflate__
+#define __libol__Inflate__
+
+#include <libOL/ByteSpan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace libol {
+    namespace Inflate {
+        struct Backend {
+            enum Id {
+                Zlib,   // zlib, streamed and fused with decryption by ChunkDecoder
+                Builtin // in-tree single-shot DEFLATE decoder over the whole decrypted chunk
+            };
+        };
+
+        // Inflates one complete gzip member held in memory
+        class Decompressor {
+        public:
+            virtual ~Decompressor() {}
+
+            /**
+             * Decodes into out and returns the decoded length
+             * \throws std::length_error if it decodes to more than capacity bytes
+             * \throws std::runtime_error if the data is corrupt or truncated
+             */
+            virtual size_t decompress(ByteSpan in, uint8_t* out, size_t capacity) = 0;
+        };
+
+        /**
+         * \param trusted skip the CRC-32 check for input that's known to be
+         * intact; only the builtin decoder honours it
+         */
+        std::unique_ptr<Decompressor> createDecompressor(Backend::Id backend, bool trusted = false);
+
+        // Backend used when none is asked for. Builtin if libOL was built with
+        // LIBOL_BUILTIN_INFLATE, zlib otherwise; can be changed at run time.
+        Backend::Id getDefaultBackend();
+        void setDefaultBackend(Backend::Id backend);
+    }
+}
+
+#endif /* defined(__libol__Inflate__) */
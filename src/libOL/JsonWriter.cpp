@@ -0,0 +1,366 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "JsonWriter.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// How much goes into the buffer before it's written out to the file
+#define JSON_FLUSH_SIZE (64 * 1024)
+
+// Decimal exponents written out in full rather than with an e
+#define JSON_MIN_FIXED_EXPONENT -5
+#define JSON_MAX_FIXED_EXPONENT 16
+
+namespace libol {
+    // Powers of ten that doubles hold exactly
+    static const double exactPowersOf10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const int maxExactPowerOf10 = 22;
+
+    // Writes val's digits to the end of buf, returning where they start
+    static char* formatDigits(uint64_t val, char* end) {
+        do {
+            *--end = (char) ('0' + val % 10);
+            val /= 10;
+        } while (val);
+        return end;
+    }
+
+    JsonWriter::JsonWriter(Style style) : file(nullptr), style(style), indent(0) {}
+
+    JsonWriter::JsonWriter(FILE* file, Style style) : file(file), style(style), indent(0) {
+        out.reserve(JSON_FLUSH_SIZE + JSON_FLUSH_SIZE / 4);
+    }
+
+    JsonWriter::~JsonWriter() {
+        try {
+            flush();
+        } catch (std::exception&) {
+            // nowhere to report it from a destructor; call flush first to find out
+        }
+    }
+
+    JsonWriter& JsonWriter::beginObject() {
+        separate();
+        out += '{';
+        levels.push_back(Level{true, 0});
+        indent++;
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::endObject() {
+        size_t count = levels.back().count;
+        levels.pop_back();
+        indent--;
+        if (style == Pretty && count) {
+            newline(indent);
+        }
+        out += '}';
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::beginArray() {
+        separate();
+        out += '[';
+        levels.push_back(Level{false, 0});
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::endArray() {
+        levels.pop_back();
+        out += ']';
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::key(const char* name) {
+        if (levels.back().count++) {
+            out += ',';
+        }
+        if (style == Pretty) {
+            newline(indent);
+        }
+        string(name, strlen(name));
+        out += style == Pretty ? ": " : ":";
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(const Value& val) {
+        switch (val.type) {
+            case Value::OBJECT:
+                beginObject();
+                for (auto& entry : val.as<Object>()) {
+                    key(entry.first.c_str());
+                    value(entry.second);
+                }
+                return endObject();
+            case Value::ARRAY: {
+                const Array& arr = val.as<Array>();
+                beginArray();
+                for (size_t i = 0; i < arr.size(); i++) {
+                    value(arr.at(i));
+                }
+                return endArray();
+            }
+            case Value::STRING: {
+                const Value::String& str = val.as<Value::String>();
+                return value(str.data(), str.size());
+            }
+            case Value::INTEGER:
+                return value(val.as<int32_t>());
+            case Value::LARGE_INTEGER:
+                return value(val.as<int64_t>());
+            case Value::FLOAT:
+                return value(val.as<float>());
+            case Value::BOOL:
+                return value(val.as<bool>());
+            default:
+                return null();
+        }
+    }
+
+    JsonWriter& JsonWriter::value(const char* val) {
+        return value(val, strlen(val));
+    }
+
+    JsonWriter& JsonWriter::value(const char* val, size_t length) {
+        separate();
+        string(val, length);
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(int32_t val) {
+        return value((int64_t) val);
+    }
+
+    JsonWriter& JsonWriter::value(int64_t val) {
+        separate();
+        integer(val);
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(uint32_t val) {
+        return value((int64_t) val);
+    }
+
+    JsonWriter& JsonWriter::value(float val) {
+        separate();
+        real(val);
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::value(bool val) {
+        separate();
+        out += val ? "true" : "false";
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::null() {
+        separate();
+        out += "null";
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::raw(const char* text) {
+        out += text;
+        written();
+        return *this;
+    }
+
+    JsonWriter& JsonWriter::end() {
+        levels.clear();
+        indent = 0;
+        out += '\n';
+        written();
+        return *this;
+    }
+
+    void JsonWriter::clear() {
+        out.clear();
+    }
+
+    void JsonWriter::flush() {
+        if (!file || out.empty()) {
+            return;
+        }
+        size_t length = out.size();
+        size_t count = fwrite(out.data(), 1, length, file);
+        out.clear();
+        if (count != length) {
+            throw std::runtime_error("JsonWriter: failed to write to file");
+        }
+    }
+
+    void JsonWriter::separate() {
+        // values in objects come after a key, which did this already
+        if (levels.empty() || levels.back().isObject) {
+            return;
+        }
+        if (levels.back().count++) {
+            out += ',';
+        }
+    }
+
+    void JsonWriter::newline(size_t depth) {
+        out += '\n';
+        out.append(depth, '\t');
+    }
+
+    void JsonWriter::string(const char* val, size_t length) {
+        static const char hexDigits[] = "0123456789abcdef";
+
+        out += '"';
+        size_t start = 0; // of the characters not yet written
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = (unsigned char) val[i];
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+
+            out.append(val + start, i - start);
+            start = i + 1;
+            switch (c) {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                case '\b':
+                    out += "\\b";
+                    break;
+                case '\f':
+                    out += "\\f";
+                    break;
+                default: {
+                    char escape[] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xf]};
+                    out.append(escape, sizeof(escape));
+                    break;
+                }
+            }
+        }
+        out.append(val + start, length - start);
+        out += '"';
+    }
+
+    void JsonWriter::integer(int64_t val) {
+        char buf[24];
+        char* end = buf + sizeof(buf);
+        uint64_t magnitude = val < 0 ? 0 - (uint64_t) val : (uint64_t) val;
+        char* start = formatDigits(magnitude, end);
+        if (val < 0) {
+            *--start = '-';
+        }
+        out.append(start, end - start);
+    }
+
+    void JsonWriter::real(float val) {
+        if (!std::isfinite(val)) {
+            out += "null"; // JSON has no NaN or infinity
+            return;
+        }
+        if (std::signbit(val)) {
+            out += '-';
+            val = -val;
+        }
+        if (val == 0) {
+            out += '0';
+            return;
+        }
+
+        // Find the fewest significant digits that read back, through a
+        // double as JSON readers do, as val
+        double x = val;
+        int leading = (int) std::floor(std::log10(x)); // exponent of the first digit
+        uint64_t mantissa = 0;
+        int scale = 0; // val is mantissa / 10^scale
+        for (int digits = 1; digits <= 9; digits++) {
+            scale = digits - 1 - leading;
+            if (scale <= maxExactPowerOf10 && -scale <= maxExactPowerOf10) {
+                // exact or correctly rounded, with the power of ten fitting in a double
+                double scaled = scale >= 0 ? x * exactPowersOf10[scale] : x / exactPowersOf10[-scale];
+                mantissa = (uint64_t) std::llround(scaled);
+                double parsed = scale >= 0 ? mantissa / exactPowersOf10[scale] : mantissa * exactPowersOf10[-scale];
+                if ((float) parsed == val) {
+                    break;
+                }
+                continue;
+            }
+
+            // otherwise let the C library round; it reads back what it
+            // writes, whatever the locale's decimal point
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.*e", digits - 1, x);
+            if ((float) strtod(buf, nullptr) != val) {
+                continue;
+            }
+            char* exponentStart = strchr(buf, 'e');
+            mantissa = 0;
+            for (char* c = buf; c != exponentStart; c++) {
+                if (*c >= '0' && *c <= '9') {
+                    mantissa = mantissa * 10 + (*c - '0');
+                }
+            }
+            scale = digits - 1 - atoi(exponentStart + 1);
+            break;
+        }
+
+        while (mantissa % 10 == 0) {
+            mantissa /= 10;
+            scale--;
+        }
+        char buf[24];
+        char* end = buf + sizeof(buf);
+        char* digits = formatDigits(mantissa, end);
+        int count = (int) (end - digits);
+        int exponent = count - 1 - scale;
+
+        if (exponent < JSON_MIN_FIXED_EXPONENT || exponent > JSON_MAX_FIXED_EXPONENT) {
+            out += digits[0];
+            if (count > 1) {
+                out += '.';
+                out.append(digits + 1, count - 1);
+            }
+            out += 'e';
+            integer(exponent);
+        } else if (exponent < 0) {
+            out += "0.";
+            out.append(-exponent - 1, '0');
+            out.append(digits, count);
+        } else if (scale <= 0) {
+            out.append(digits, count);
+            out.append(-scale, '0');
+        } else {
+            out.append(digits, count - scale);
+            out += '.';
+            out.append(digits + count - scale, scale);
+        }
+    }
+
+    void JsonWriter::written() {
+        if (file && out.size() >= JSON_FLUSH_SIZE) {
+            flush();
+        }
+    }
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__JsonWriter__
+#define __libol__JsonWriter__
+
+#include "Value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace libol {
+    // Writes JSON straight into a buffer, which is handed to a FILE* as it
+    // fills if there is one, without building strings for the parts:
+    //     JsonWriter writer(stdout, JsonWriter::Compact);
+    //     writer.beginObject().key("type").value(pkt.typeName().c_str()).key("data").value(pkt.data).endObject().end();
+    // Inside an object, every value has to follow a key. Pretty puts each
+    // object entry on its own line and arrays on one, as Value::toString
+    // always has; Compact has no whitespace at all, so with end() after each
+    // document the output is NDJSON. Floats are written with the fewest
+    // digits that read back as the same float, without regard to locale.
+    class JsonWriter {
+    public:
+        enum Style {
+            Pretty,
+            Compact
+        };
+
+        // Into buffer()
+        explicit JsonWriter(Style style = Pretty);
+
+        // Into file, a buffer's worth at a time; whatever's left is written out on destruction
+        explicit JsonWriter(FILE* file, Style style = Pretty);
+
+        JsonWriter(const JsonWriter&) = delete;
+        JsonWriter& operator=(const JsonWriter&) = delete;
+        ~JsonWriter();
+
+        JsonWriter& beginObject();
+        JsonWriter& endObject();
+        JsonWriter& beginArray();
+        JsonWriter& endArray();
+        JsonWriter& key(const char* name);
+
+        JsonWriter& value(const Value& val);
+        JsonWriter& value(const char* val);
+        JsonWriter& value(const char* val, size_t length);
+        JsonWriter& value(int32_t val);
+        JsonWriter& value(int64_t val);
+        JsonWriter& value(uint32_t val);
+        JsonWriter& value(float val);
+        JsonWriter& value(bool val);
+        JsonWriter& null();
+
+        // Text outside of any JSON, as is
+        JsonWriter& raw(const char* text);
+
+        // Ends the line, ready for the next document
+        JsonWriter& end();
+
+        // What's been written and not yet flushed to the file
+        const std::string& buffer() const {
+            return out;
+        }
+
+        // Empties the buffer without writing it anywhere, keeping its memory for reuse
+        void clear();
+
+        /**
+         * Writes the buffer out to the file, if there is one
+         * \throws std::runtime_error if the file can't be written to
+         */
+        void flush();
+
+    private:
+        struct Level {
+            bool isObject;
+            size_t count;
+        };
+
+        FILE* file;
+        Style style;
+        std::string out;
+        std::vector<Level> levels;
+        size_t indent; // objects open; arrays don't indent their elements
+
+        void separate();
+        void newline(size_t depth);
+        void string(const char* val, size_t length);
+        void integer(int64_t val);
+        void real(float val);
+        void written();
+    };
+}
+
+#endif /* defined(__libol__JsonWriter__) */
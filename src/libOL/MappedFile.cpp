@@ -0,0 +1,71 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace libol {
+    static std::runtime_error mapError(const std::string& what, const std::string& path) {
+        return std::runtime_error("MappedFile: " + what + " " + path + ": " + strerror(errno));
+    }
+
+    MappedFile::MappedFile(const std::string& path) : base(nullptr), length(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw mapError("failed to open", path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            auto error = mapError("failed to stat", path);
+            ::close(fd);
+            throw error;
+        }
+
+        length = st.st_size;
+        if (length > 0) {
+            void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                auto error = mapError("failed to map", path);
+                ::close(fd);
+                throw error;
+            }
+            base = static_cast<const uint8_t*>(mapping);
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) : base(other.base), length(other.length) {
+        other.base = nullptr;
+        other.length = 0;
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) {
+        if (this != &other) {
+            if (base) {
+                munmap(const_cast<uint8_t*>(base), length);
+            }
+            base = other.base;
+            length = other.length;
+            other.base = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        if (base) {
+            munmap(const_cast<uint8_t*>(base), length);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__MappedFile__
+#define __libol__MappedFile__
+
+#include "ByteSpan.h"
+
+#include <cstdint>
+#include <string>
+
+namespace libol {
+    // Read-only memory mapping of a whole file. Movable, not copyable.
+    class MappedFile {
+        const uint8_t* base;
+        size_t length;
+
+    public:
+        /**
+         * \throws std::runtime_error if the file can't be opened or mapped
+         */
+        explicit MappedFile(const std::string& path);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other);
+        MappedFile& operator=(MappedFile&& other);
+        ~MappedFile();
+
+        const uint8_t* data() const { return base; }
+        size_t size() const { return length; }
+        ByteSpan span() const { return ByteSpan(base, length); }
+    };
+}
+
+#endif /* defined(__libol__MappedFile__) */
@@ -3,10 +3,68 @@
 
 #include "Packet.h"
 #include "PacketParser.h"
+#include "Parallel.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+// Blocks a worker takes at a time; most decode in well under a microsecond
+#define DECODE_BATCH_SIZE 64
 
 namespace libol {
     Packet Packet::decode(Block& block) {
         return PacketParser::getInstance().decode(block);
     }
+
+    bool Packet::visit(Block& block, PacketVisitor& visitor) {
+        return PacketParser::getInstance().visit(block, visitor);
+    }
+
+    std::vector<Packet> Packet::decodeParallel(std::vector<Block>& blocks, unsigned threadCount) {
+        std::vector<Packet> result(blocks.size());
+        const PacketParser& parser = PacketParser::getInstance();
+
+        size_t batches = (blocks.size() + DECODE_BATCH_SIZE - 1) / DECODE_BATCH_SIZE;
+        threadCount = Parallel::getThreadCount(threadCount, batches);
+
+        // Batches are handed out in order and always finished unless they fail,
+        // so once everything stops, the lowest failing index is the block a
+        // serial decode would have thrown on.
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr error;
+        size_t errorIndex = blocks.size();
+        std::mutex errorMutex;
+
+        auto work = [&] () {
+            ValueArena::Scope scope(std::make_shared<ValueArena>());
+            size_t start;
+            while (!failed && (start = next.fetch_add(DECODE_BATCH_SIZE)) < blocks.size()) {
+                size_t end = std::min<size_t>(start + DECODE_BATCH_SIZE, blocks.size());
+                for (size_t i = start; i < end; i++) {
+                    try {
+                        result[i] = parser.decode(blocks[i]);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (i < errorIndex) {
+                            errorIndex = i;
+                            error = std::current_exception();
+                        }
+                        failed = true;
+                        return;
+                    }
+                }
+            }
+        };
+
+        Parallel::run(threadCount, failed, work);
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return result;
+    }
 }
@@ -7,23 +7,70 @@
 #include "Value.h"
 #include "Constants.h"
 #include "Block.h"
+#include "ValueArena.h"
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace libol {
+    class PacketParser;
+    class PacketVisitor;
+
     struct Packet {
-        ~Packet() {
-            data.destroy();
-        };
+        Packet() : timestamp(0), type(0), entityId(0), isDecoded(false), name(nullptr) {}
+
+        // Moved rather than copied, since copying data is a deep copy. If data
+        // was decoded inside a ValueArena::Scope, it lives in that arena,
+        // which the packet keeps alive.
+        Packet(const Packet&) = delete;
+        Packet& operator=(const Packet&) = delete;
+        Packet(Packet&&) = default;
+        Packet& operator=(Packet&&) = default;
 
         float timestamp;
         PacketType::Id type;
         uint32_t entityId;
 
         bool isDecoded;
-        std::string typeName;
+        std::shared_ptr<ValueArena> arena; // where data lives, null if on the heap; declared first so it outlives data
         Value data;
 
+        // The decoder's name, shared by every packet of the type; empty if not decoded
+        const std::string& typeName() const {
+            static const std::string none;
+            return name ? *name : none;
+        }
+
         static Packet decode(Block& block);
+
+        /**
+         * Decodes the block into its packet's Data struct (see PacketDecoders.h)
+         * and hands it to the matching visitor.visit overload, or to
+         * visitor.visitUnknown if it has no decoder. No Value tree is built,
+         * and the fixed-size packets don't allocate at all.
+         * \returns whether the block had a decoder
+         * \throws ParseException if the block fails to decode
+         */
+        static bool visit(Block& block, PacketVisitor& visitor);
+
+        /**
+         * Decodes the blocks across threadCount threads (0 for one per core),
+         * in the same order and with the same results as decoding them one by
+         * one. Blocks only depend on the BlockReader state for their time,
+         * type and entityId, which are resolved by the time they're read, so
+         * a chunk can be read (cheaply, as views, see
+         * BlockReader::readBlockViewsFromBuffer) and then decoded out of order.
+         * Each thread builds its packets' data in one ValueArena, freed once
+         * all of that thread's packets are gone.
+         * \throws ParseException from the first block that fails to decode
+         */
+        static std::vector<Packet> decodeParallel(std::vector<Block>& blocks, unsigned threadCount = 0);
+
+    private:
+        friend class PacketParser;
+
+        const std::string* name;
     };
 }
 
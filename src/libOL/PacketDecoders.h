@@ -13,509 +13,920 @@
 #include <cstdint>
 #include <cmath>
 #include <array>
+#include <utility>
+#include <vector>
+
+/* Packet decoders
+ * Each packet class has:
+ *   struct Data                          the packet's fields as plain values
+ *   static Data decodeData(Block&)       reads them, without allocating unless the packet has variable-length lists
+ *   static Value toValue(const Data&)    builds the Value tree Packet::decode hands out
+ *   static Value decode(Block&)          both at once
+ * See PacketVisitor for getting at the Data of a block of any type.
+ */
 
 namespace libol {
     class SetAbilityLevelPkt {
     public:
         static const PacketType::Id type = PacketType::SetAbilityLevel;
-        static std::string name() { return "SetAbilityLevel"; }
+        static const char* name() { return "SetAbilityLevel"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint8_t abilityId;
+            uint8_t level;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x3);
 
-            Object data = Object();
+            Data data;
+
+            data.abilityId = block.payload()[0];
+            data.level = block.payload()[1];
 
-            data.setv("abilityId", block.content[0]);
-            data.setv("level", block.content[1]);
+            //assert(block.payload()[2] == 0x00);
 
-            //assert(block.content[2] == 0x00);
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("abilityId", data.abilityId);
+            obj.setv("level", data.level);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class GoldRewardPkt {
     public:
         static const PacketType::Id type = PacketType::GoldReward;
-        static std::string name() { return "GoldReward"; }
+        static const char* name() { return "GoldReward"; }
+
+        struct Data {
+            uint32_t receiverEntId;
+            uint32_t killedEntId;
+            float amount;
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0xc);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("receiverEntId", stream.read<uint32_t>());
-            data.setv("killedEntId", stream.read<uint32_t>());
-            data.setv("amount", stream.read<float>());
+            data.receiverEntId = stream.read<uint32_t>();
+            data.killedEntId = stream.read<uint32_t>();
+            data.amount = stream.read<float>();
 
-            return Value::create(data);
+            return data;
         }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(3);
+            obj.setv("receiverEntId", data.receiverEntId);
+            obj.setv("killedEntId", data.killedEntId);
+            obj.setv("amount", data.amount);
+            return Value::create(std::move(obj));
+        }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class GoldGainPkt {
     public:
         static const PacketType::Id type = PacketType::GoldGain;
-        static std::string name() { return "GoldGain"; }
+        static const char* name() { return "GoldGain"; }
+
+        struct Data {
+            uint32_t receiverEntId;
+            float amount;
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x8);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("receiverEntId", stream.read<uint32_t>());
-            data.setv("amount", stream.read<float>());
+            data.receiverEntId = stream.read<uint32_t>();
+            data.amount = stream.read<float>();
 
-            return Value::create(data);
+            return data;
         }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("receiverEntId", data.receiverEntId);
+            obj.setv("amount", data.amount);
+            return Value::create(std::move(obj));
+        }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetInventoryPkt {
     public:
         static const PacketType::Id type = PacketType::SetInventory;
-        static std::string name() { return "SetInventory"; }
-
-        static Value decode(Block& block) {
+        static const char* name() { return "SetInventory"; }
+
+        struct Item {
+            uint32_t itemId;
+            uint8_t slotId;
+            uint8_t stacks;
+            uint8_t charges;
+            float cooldown;
+            float baseCooldown;
+        };
+
+        struct Data {
+            std::array<Item, 10> items;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x98);
 
-            Object data = Object();
-            std::array<Object, 10> items;
+            Data data;
+            auto& items = data.items;
 
             auto stream = block.createStream(0x2);
 
             for(size_t i = 0; i < items.size(); i++) {
-                items[i].setv("itemId", stream.read<uint32_t>());
-                items[i].setv("slotId", stream.get());
-                items[i].setv("stacks", stream.get());
-                items[i].setv("charges", stream.get());
+                items[i].itemId = stream.read<uint32_t>();
+                items[i].slotId = stream.get();
+                items[i].stacks = stream.get();
+                items[i].charges = stream.get();
             }
 
             for(size_t i = 0; i < items.size(); i++) {
-                items[i].setv("cooldown", stream.read<float>());
+                items[i].cooldown = stream.read<float>();
             }
 
             for(size_t i = 0; i < items.size(); i++) {
-                items[i].setv("baseCooldown", stream.read<float>());
+                items[i].baseCooldown = stream.read<float>();
             }
 
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(1);
+
             Array itemsArr = Array();
-            for(auto& item : items)
-                itemsArr.pushv(item);
-            data.setv("items", itemsArr);
+            itemsArr.reserve(data.items.size());
+            for(auto& item : data.items) {
+                Object itemObj = Object();
+                itemObj.reserve(6);
+                itemObj.setv("itemId", item.itemId);
+                itemObj.setv("slotId", item.slotId);
+                itemObj.setv("stacks", item.stacks);
+                itemObj.setv("charges", item.charges);
+                itemObj.setv("cooldown", item.cooldown);
+                itemObj.setv("baseCooldown", item.baseCooldown);
+                itemsArr.pushv(std::move(itemObj));
+            }
+            obj.setv("items", std::move(itemsArr));
 
-            return Value::create(data);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class ItemPurchasePkt {
     public:
         static const PacketType::Id type = PacketType::ItemPurchase;
-        static std::string name() { return "ItemPurchase"; }
+        static const char* name() { return "ItemPurchase"; }
+
+        struct Data {
+            uint32_t itemId;
+            uint8_t slot;
+            uint16_t stacks;
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x8);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("itemId", stream.read<uint32_t>());
-            data.setv("slot", stream.get());
-            data.setv("stacks", stream.read<uint16_t>());
+            data.itemId = stream.read<uint32_t>();
+            data.slot = stream.get();
+            data.stacks = stream.read<uint16_t>();
 
-            //assert(block.content[0x7] == 0x40);
+            //assert(block.payload()[0x7] == 0x40);
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(3);
+            obj.setv("itemId", data.itemId);
+            obj.setv("slot", data.slot);
+            obj.setv("stacks", data.stacks);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class ChampionSpawnPkt {
     public:
         static const PacketType::Id type = PacketType::ChampionSpawn;
-        static std::string name() { return "ChampionSpawn"; }
+        static const char* name() { return "ChampionSpawn"; }
+
+        struct Data {
+            uint32_t entityId;
+            uint32_t clientId;
+            char summonerName[0x81]; // null-terminated
+            char championName[0x11]; // null-terminated
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0xC3);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("entityId", stream.read<uint32_t>());
-            data.setv("clientId", stream.read<uint32_t>());
+            data.entityId = stream.read<uint32_t>();
+            data.clientId = stream.read<uint32_t>();
 
             stream.ignore(0xA); // unknown
 
             // Summoner name
-            char summonerChars[0x81];
-            stream.read(summonerChars, 0x80);
-            summonerChars[0x80] = 0x00;
-            data.setv("summonerName", std::string(summonerChars));
+            stream.read(data.summonerName, 0x80);
+            data.summonerName[0x80] = 0x00;
 
             // Champion name
-            char championChars[0x11];
-            stream.read(championChars, 0x10);
-            championChars[0x10] = 0x00;
-            data.setv("championName", std::string(championChars));
+            stream.read(data.championName, 0x10);
+            data.championName[0x10] = 0x00;
 
             stream.ignore(0x21); // unknown
 
-            return Value::create(data);
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(4);
+            obj.setv("entityId", data.entityId);
+            obj.setv("clientId", data.clientId);
+            obj.setv("summonerName", std::string(data.summonerName));
+            obj.setv("championName", std::string(data.championName));
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SummonerDataPkt {
     public:
         static const PacketType::Id type = PacketType::SummonerData;
-        static std::string name() { return "SummonerData"; }
-
-        static Value decode(Block& block) {
+        static const char* name() { return "SummonerData"; }
+
+        struct Mastery {
+            uint8_t id;
+            uint8_t tree;
+            int32_t talentId;
+            uint8_t pointsSpent;
+        };
+
+        struct Data {
+            std::array<uint32_t, 30> runes;
+            uint32_t spell1;
+            uint32_t spell2;
+            std::array<Mastery, 79> masteries;
+            size_t masteryCount; // how many of masteries are filled in
+            uint8_t level;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x212);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            Array runes = Array();
-            for(size_t i = 0; i < 30; i++) {
-                runes.pushv(stream.read<uint32_t>());
+            for(size_t i = 0; i < data.runes.size(); i++) {
+                data.runes[i] = stream.read<uint32_t>();
             }
-            data.setv("runes", runes);
 
-            uint32_t spell1Id = stream.read<uint32_t>();
-            uint32_t spell2Id = stream.read<uint32_t>();
-            data.setv("spell1", spell1Id);
-            data.setv("spell1Name", SummonerSpell::getName(spell1Id));
-            data.setv("spell2", spell2Id);
-            data.setv("spell2Name", SummonerSpell::getName(spell2Id));
+            data.spell1 = stream.read<uint32_t>();
+            data.spell2 = stream.read<uint32_t>();
 
-            Array masteries = Array();
-            size_t masteryCount = 0;
-            while(masteryCount++ < 79) {
+            data.masteryCount = 0;
+            while(data.masteryCount < data.masteries.size()) {
                 auto pos = stream.tellg();
                 stream.ignore(2);
                 uint8_t test = stream.get();
                 stream.seekg(pos);
                 if(test != 0x03) break;
 
-                Object entry = Object();
+                Mastery& entry = data.masteries[data.masteryCount++];
                 uint8_t id = stream.get();
-                entry.setv("id", id);
+                entry.id = id;
                 uint8_t tree = stream.get();
-                entry.setv("tree", tree);
-                entry.setv("talentId", 4100 + (tree - 0x74) * 0x64 + ((id >> 4) - 0x03) * 0x0A + (id & 0x0F));
+                entry.tree = tree;
+                entry.talentId = 4100 + (tree - 0x74) * 0x64 + ((id >> 4) - 0x03) * 0x0A + (id & 0x0F);
                 EXPECT(stream.get() == 0x03);
                 EXPECT(stream.get() == 0x00);
-                entry.setv("pointsSpent", stream.get());
-                masteries.pushv(entry);
+                entry.pointsSpent = stream.get();
             }
-            data.setv("masteries", masteries);
 
-            data.setv("level", block.content[0x210]);
+            data.level = block.payload()[0x210];
 
-            return Value::create(data);
+            return data;
         }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(7);
+
+            Array runes = Array();
+            runes.reserve(data.runes.size());
+            for(uint32_t rune : data.runes) {
+                runes.pushv(rune);
+            }
+            obj.setv("runes", std::move(runes));
+
+            obj.setv("spell1", data.spell1);
+            obj.setv("spell1Name", SummonerSpell::getName(data.spell1));
+            obj.setv("spell2", data.spell2);
+            obj.setv("spell2Name", SummonerSpell::getName(data.spell2));
+
+            Array masteries = Array();
+            masteries.reserve(data.masteryCount);
+            for(size_t i = 0; i < data.masteryCount; i++) {
+                const Mastery& mastery = data.masteries[i];
+                Object entry = Object();
+                entry.reserve(4);
+                entry.setv("id", mastery.id);
+                entry.setv("tree", mastery.tree);
+                entry.setv("talentId", mastery.talentId);
+                entry.setv("pointsSpent", mastery.pointsSpent);
+                masteries.pushv(std::move(entry));
+            }
+            obj.setv("masteries", std::move(masteries));
+
+            obj.setv("level", data.level);
+
+            return Value::create(std::move(obj));
+        }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class PlayerStatsPkt {
     public:
         static const PacketType::Id type = PacketType::PlayerStats;
-        static std::string name() { return "PlayerStats"; }
+        static const char* name() { return "PlayerStats"; }
+
+        struct Data {
+            bool hasJungleStats; // whether the two neutralMinionsKilledIn* fields are set
+            uint32_t assists;
+            uint32_t kills;
+            uint32_t doubleKills;
+            uint32_t unrealKills;
+            float goldEarned;
+            float goldSpent;
+            uint32_t currentKillingSpree;
+            float largestCriticalStrike;
+            uint32_t largestKillingSpree;
+            uint32_t largestMultiKill;
+            float longestTimeSpentLiving;
+            float magicDamageDealt;
+            float magicDamageDealtToChampions;
+            float magicDamageTaken;
+            uint32_t minionsKilled;
+            uint32_t neutralMinionsKilled;
+            uint32_t neutralMinionsKilledInEnemyJungle;
+            uint32_t neutralMinionsKilledInTeamJungle;
+            uint32_t deaths;
+            uint32_t pentaKills;
+            float physicalDamageDealt;
+            float physicalDamageDealtToChampions;
+            float physicalDamageTaken;
+            uint32_t quadraKills;
+            uint32_t teamId;
+            float totalDamageDealt;
+            float totalDamageDealtToChamptions;
+            float totalDamageTaken;
+            uint32_t totalHeal;
+            float totalTimeCrowdControlDealt;
+            float totalTimeSpentDead;
+            uint32_t totalUnitsHealed;
+            uint32_t tripleKills;
+            float trueDamageDealt;
+            float trueDamageDealtToChamptions;
+            float trueDamageTaken;
+            uint32_t towerKills;
+            uint32_t inhibitorKills;
+            uint32_t wardsKilled;
+            uint32_t wardsPlaced;
+        };
+
+        static Data decodeData(Block& block) {
+            Data data;
 
-        static Value decode(Block& block) {
-            bool hasJungleStats;
             switch(block.size) {
                 case 0x128:
-                    hasJungleStats = false;
+                    data.hasJungleStats = false;
                     break;
                 case 0x130:
-                    hasJungleStats = true;
+                    data.hasJungleStats = true;
                     break;
                 default:
                     throw ParseException("PlayerStats: unknown size " + std::to_string(block.size));
             }
 
-            Object data = Object();
-
             auto stream = block.createStream(0x4);
 
-            data.setv("assists", stream.read<uint32_t>());
+            data.assists = stream.read<uint32_t>();
             stream.ignore(0x4);
-            data.setv("kills", stream.read<uint32_t>());
+            data.kills = stream.read<uint32_t>();
             stream.ignore(0x4);
-            data.setv("doubleKills", stream.read<uint32_t>());
+            data.doubleKills = stream.read<uint32_t>();
             stream.ignore(3 * 0x4);
-            data.setv("unrealKills", stream.read<uint32_t>());
-            data.setv("goldEarned", stream.read<float>());
-            data.setv("goldSpent", stream.read<float>());
+            data.unrealKills = stream.read<uint32_t>();
+            data.goldEarned = stream.read<float>();
+            data.goldSpent = stream.read<float>();
             stream.ignore(10 * 0x4);
-            data.setv("currentKillingSpree", stream.read<uint32_t>());
-            data.setv("largestCriticalStrike", stream.read<float>());
-            data.setv("largestKillingSpree", stream.read<uint32_t>());
-            data.setv("largestMultiKill", stream.read<uint32_t>());
+            data.currentKillingSpree = stream.read<uint32_t>();
+            data.largestCriticalStrike = stream.read<float>();
+            data.largestKillingSpree = stream.read<uint32_t>();
+            data.largestMultiKill = stream.read<uint32_t>();
             stream.ignore(0x4);
-            data.setv("longestTimeSpentLiving", stream.read<float>());
-            data.setv("magicDamageDealt", stream.read<float>());
-            data.setv("magicDamageDealtToChampions", stream.read<float>());
-            data.setv("magicDamageTaken", stream.read<float>());
-            data.setv("minionsKilled", stream.read<uint32_t>());
+            data.longestTimeSpentLiving = stream.read<float>();
+            data.magicDamageDealt = stream.read<float>();
+            data.magicDamageDealtToChampions = stream.read<float>();
+            data.magicDamageTaken = stream.read<float>();
+            data.minionsKilled = stream.read<uint32_t>();
             stream.ignore(0x2); // Padding
-            data.setv("neutralMinionsKilled", stream.read<uint32_t>());
-            if(hasJungleStats) {
-                data.setv("neutralMinionsKilledInEnemyJungle", stream.read<uint32_t>());
-                data.setv("neutralMinionsKilledInTeamJungle", stream.read<uint32_t>());
+            data.neutralMinionsKilled = stream.read<uint32_t>();
+            if(data.hasJungleStats) {
+                data.neutralMinionsKilledInEnemyJungle = stream.read<uint32_t>();
+                data.neutralMinionsKilledInTeamJungle = stream.read<uint32_t>();
+            } else {
+                data.neutralMinionsKilledInEnemyJungle = 0;
+                data.neutralMinionsKilledInTeamJungle = 0;
             }
             stream.ignore(0x4);
-            data.setv("deaths", stream.read<uint32_t>());
-            data.setv("pentaKills", stream.read<uint32_t>());
-            data.setv("physicalDamageDealt", stream.read<float>());
-            data.setv("physicalDamageDealtToChampions", stream.read<float>());
-            data.setv("physicalDamageTaken", stream.read<float>());
+            data.deaths = stream.read<uint32_t>();
+            data.pentaKills = stream.read<uint32_t>();
+            data.physicalDamageDealt = stream.read<float>();
+            data.physicalDamageDealtToChampions = stream.read<float>();
+            data.physicalDamageTaken = stream.read<float>();
             stream.ignore(0x4);
-            data.setv("quadraKills", stream.read<uint32_t>());
+            data.quadraKills = stream.read<uint32_t>();
             stream.ignore(9 * 0x4);
-            data.setv("teamId", stream.read<uint32_t>());
+            data.teamId = stream.read<uint32_t>();
             stream.ignore(4 * 0x4);
-            data.setv("totalDamageDealt", stream.read<float>());
-            data.setv("totalDamageDealtToChamptions", stream.read<float>());
-            data.setv("totalDamageTaken", stream.read<float>());
-            data.setv("totalHeal", stream.read<uint32_t>());
-            data.setv("totalTimeCrowdControlDealt", stream.read<float>());
-            data.setv("totalTimeSpentDead", stream.read<float>());
-            data.setv("totalUnitsHealed", stream.read<uint32_t>());
-            data.setv("tripleKills", stream.read<uint32_t>());
-            data.setv("trueDamageDealt", stream.read<float>());
-            data.setv("trueDamageDealtToChamptions", stream.read<float>());
-            data.setv("trueDamageTaken", stream.read<float>());
-            data.setv("towerKills", stream.read<uint32_t>());
-            data.setv("inhibitorKills", stream.read<uint32_t>());
+            data.totalDamageDealt = stream.read<float>();
+            data.totalDamageDealtToChamptions = stream.read<float>();
+            data.totalDamageTaken = stream.read<float>();
+            data.totalHeal = stream.read<uint32_t>();
+            data.totalTimeCrowdControlDealt = stream.read<float>();
+            data.totalTimeSpentDead = stream.read<float>();
+            data.totalUnitsHealed = stream.read<uint32_t>();
+            data.tripleKills = stream.read<uint32_t>();
+            data.trueDamageDealt = stream.read<float>();
+            data.trueDamageDealtToChamptions = stream.read<float>();
+            data.trueDamageTaken = stream.read<float>();
+            data.towerKills = stream.read<uint32_t>();
+            data.inhibitorKills = stream.read<uint32_t>();
             stream.ignore(0x4);
-            data.setv("wardsKilled", stream.read<uint32_t>());
-            data.setv("wardsPlaced", stream.read<uint32_t>());
+            data.wardsKilled = stream.read<uint32_t>();
+            data.wardsPlaced = stream.read<uint32_t>();
             stream.ignore(2 * 0x4);
             stream.ignore(0x2); // Padding
 
-            return Value::create(data);
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(data.hasJungleStats ? 40 : 38);
+            obj.setv("assists", data.assists);
+            obj.setv("kills", data.kills);
+            obj.setv("doubleKills", data.doubleKills);
+            obj.setv("unrealKills", data.unrealKills);
+            obj.setv("goldEarned", data.goldEarned);
+            obj.setv("goldSpent", data.goldSpent);
+            obj.setv("currentKillingSpree", data.currentKillingSpree);
+            obj.setv("largestCriticalStrike", data.largestCriticalStrike);
+            obj.setv("largestKillingSpree", data.largestKillingSpree);
+            obj.setv("largestMultiKill", data.largestMultiKill);
+            obj.setv("longestTimeSpentLiving", data.longestTimeSpentLiving);
+            obj.setv("magicDamageDealt", data.magicDamageDealt);
+            obj.setv("magicDamageDealtToChampions", data.magicDamageDealtToChampions);
+            obj.setv("magicDamageTaken", data.magicDamageTaken);
+            obj.setv("minionsKilled", data.minionsKilled);
+            obj.setv("neutralMinionsKilled", data.neutralMinionsKilled);
+            if(data.hasJungleStats) {
+                obj.setv("neutralMinionsKilledInEnemyJungle", data.neutralMinionsKilledInEnemyJungle);
+                obj.setv("neutralMinionsKilledInTeamJungle", data.neutralMinionsKilledInTeamJungle);
+            }
+            obj.setv("deaths", data.deaths);
+            obj.setv("pentaKills", data.pentaKills);
+            obj.setv("physicalDamageDealt", data.physicalDamageDealt);
+            obj.setv("physicalDamageDealtToChampions", data.physicalDamageDealtToChampions);
+            obj.setv("physicalDamageTaken", data.physicalDamageTaken);
+            obj.setv("quadraKills", data.quadraKills);
+            obj.setv("teamId", data.teamId);
+            obj.setv("totalDamageDealt", data.totalDamageDealt);
+            obj.setv("totalDamageDealtToChamptions", data.totalDamageDealtToChamptions);
+            obj.setv("totalDamageTaken", data.totalDamageTaken);
+            obj.setv("totalHeal", data.totalHeal);
+            obj.setv("totalTimeCrowdControlDealt", data.totalTimeCrowdControlDealt);
+            obj.setv("totalTimeSpentDead", data.totalTimeSpentDead);
+            obj.setv("totalUnitsHealed", data.totalUnitsHealed);
+            obj.setv("tripleKills", data.tripleKills);
+            obj.setv("trueDamageDealt", data.trueDamageDealt);
+            obj.setv("trueDamageDealtToChamptions", data.trueDamageDealtToChamptions);
+            obj.setv("trueDamageTaken", data.trueDamageTaken);
+            obj.setv("towerKills", data.towerKills);
+            obj.setv("inhibitorKills", data.inhibitorKills);
+            obj.setv("wardsKilled", data.wardsKilled);
+            obj.setv("wardsPlaced", data.wardsPlaced);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class MovementGroupPkt {
     public:
         static const PacketType::Id type = PacketType::MovementGroup;
-        static std::string name() { return "MovementGroup"; }
+        static const char* name() { return "MovementGroup"; }
+
+        struct Point {
+            int32_t x;
+            int32_t y;
+        };
 
-        static Value decode(Block& block) {
-            Object data = Object();
+        struct Update {
+            uint32_t entityId;
+            Point position;
+            std::vector<Point> waypoints;
+        };
+
+        struct Data {
+            uint32_t timestamp; // in ms from start
+            std::vector<Update> updates;
+        };
+
+        static Data decodeData(Block& block) {
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("timestamp", stream.read<uint32_t>()); // in ms from start
+            data.timestamp = stream.read<uint32_t>();
             uint16_t numUpdates = stream.read<uint16_t>();
 
-            Array updates = Array();
-            while(numUpdates--) {
-                Object update = Object();
-
+            data.updates.resize(numUpdates);
+            for(auto& update : data.updates) {
                 uint8_t numCoords = stream.get(); // includes the 2 start coords
-                update.setv("entityId", stream.read<uint32_t>());
+                update.entityId = stream.read<uint32_t>();
 
                 if(numCoords % 2) {
                     stream.ignore(1);
                     numCoords--;
                 }
+                REQUIRE(numCoords >= 2);
 
-                std::vector<uint8_t> bitmask; // defines if a coord is relative for non-start coords
+                std::array<uint8_t, 32> bitmask; // defines if a coord is relative for non-start coords
                 if(numCoords > 2) {
                     size_t bmSize = std::floor((numCoords - 3) / 8.f) + 1;
                     for (size_t i = 0; i < bmSize; i++)
-                        bitmask.push_back(stream.get());
+                        bitmask[i] = stream.get();
                 }
 
                 int16_t startX = stream.read<int16_t>();
                 int16_t startY = stream.read<int16_t>();
-                Object start = Object();
-                start.setv("x", startX);
-                start.setv("y", startY);
-                update.setv("position", start);
+                update.position.x = startX;
+                update.position.y = startY;
 
-                Array waypoints = Array();
+                update.waypoints.reserve((numCoords - 2) / 2);
                 for(size_t i = 0; i < (size_t)(numCoords - 2); i++) {
-                    Object point = Object();
+                    Point point;
 
                     if(bitmask[floor(i  / 8.f)] & (1 << i % 8))
-                        point.setv("x", startX + stream.read<int8_t>());
+                        point.x = startX + stream.read<int8_t>();
                     else
-                        point.setv("x", stream.read<int16_t>());
+                        point.x = stream.read<int16_t>();
 
                     i++;
                     if(bitmask[floor(i / 8.f)] & (1 << i % 8))
-                        point.setv("y", startY + stream.read<int8_t>());
+                        point.y = startY + stream.read<int8_t>();
                     else
-                        point.setv("y", stream.read<int16_t>());
+                        point.y = stream.read<int16_t>();
 
-                    waypoints.pushv(point);
+                    update.waypoints.push_back(point);
                 }
-                update.setv("waypoints", waypoints);
+            }
+
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+
+            obj.setv("timestamp", data.timestamp);
+
+            Array updates = Array();
+            updates.reserve(data.updates.size());
+            for(auto& update : data.updates) {
+                Object updateObj = Object();
+                updateObj.reserve(3);
+                updateObj.setv("entityId", update.entityId);
+
+                Object start = Object();
+                start.reserve(2);
+                start.setv("x", update.position.x);
+                start.setv("y", update.position.y);
+                updateObj.setv("position", std::move(start));
 
-                updates.pushv(update);
+                Array waypoints = Array();
+                waypoints.reserve(update.waypoints.size());
+                for(auto& waypoint : update.waypoints) {
+                    Object point = Object();
+                    point.reserve(2);
+                    point.setv("x", waypoint.x);
+                    point.setv("y", waypoint.y);
+                    waypoints.pushv(std::move(point));
+                }
+                updateObj.setv("waypoints", std::move(waypoints));
+
+                updates.pushv(std::move(updateObj));
             }
-            data.setv("updates", updates);
+            obj.setv("updates", std::move(updates));
 
-            return Value::create(data);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetOwnershipPkt {
     public:
         static const PacketType::Id type = PacketType::SetOwnership;
-        static std::string name() { return "SetOwnership"; }
+        static const char* name() { return "SetOwnership"; }
+
+        struct Data {
+            uint32_t ownerEntId;
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x4);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("ownerEntId", stream.read<uint32_t>());
+            data.ownerEntId = stream.read<uint32_t>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(1);
+            obj.setv("ownerEntId", data.ownerEntId);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class AttentionPingPkt {
     public:
         static const PacketType::Id type = PacketType::AttentionPing;
-        static std::string name() { return "AttentionPing"; }
+        static const char* name() { return "AttentionPing"; }
+
+        struct Data {
+            float x;
+            float y;
+            uint32_t targetEntId;
+            uint32_t playerEntId;
+            uint8_t type; // see AttentionPingType
+        };
 
-        static Value decode(Block& block) {
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x11);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("x", stream.read<float>());
-            data.setv("y", stream.read<float>());
-            data.setv("targetEntId", stream.read<uint32_t>());
-            data.setv("playerEntId", stream.read<uint32_t>());
+            data.x = stream.read<float>();
+            data.y = stream.read<float>();
+            data.targetEntId = stream.read<uint32_t>();
+            data.playerEntId = stream.read<uint32_t>();
+            data.type = stream.read<uint8_t>();
 
-            uint8_t type = stream.read<uint8_t>();
-            data.setv("type", type);
-            data.setv("typeName", AttentionPingType::getName(type));
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(6);
+            obj.setv("x", data.x);
+            obj.setv("y", data.y);
+            obj.setv("targetEntId", data.targetEntId);
+            obj.setv("playerEntId", data.playerEntId);
+            obj.setv("type", data.type);
+            obj.setv("typeName", AttentionPingType::getName(data.type));
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class PlayEmotePkt {
     public:
         static const PacketType::Id type = PacketType::PlayEmote;
-        static std::string name() { return "PlayEmote"; }
+        static const char* name() { return "PlayEmote"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint8_t type; // TODO: find out enum
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x1);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("type", stream.read<uint8_t>()); // TODO: find out enum
+            data.type = stream.read<uint8_t>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(1);
+            obj.setv("type", data.type);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class DamageDonePkt {
     public:
         static const PacketType::Id type = PacketType::DamageDone;
-        static std::string name() { return "DamageDone"; }
+        static const char* name() { return "DamageDone"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint8_t type; // TODO: find out enum
+            uint32_t receiverEntId;
+            uint32_t sourceEntId;
+            float amount;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0xd);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("type", stream.read<uint8_t>()); // TODO: find out enum
-            data.setv("receiverEntId", stream.read<uint32_t>());
-            data.setv("sourceEntId", stream.read<uint32_t>());
-            data.setv("amount", stream.read<float>());
+            data.type = stream.read<uint8_t>();
+            data.receiverEntId = stream.read<uint32_t>();
+            data.sourceEntId = stream.read<uint32_t>();
+            data.amount = stream.read<float>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(4);
+            obj.setv("type", data.type);
+            obj.setv("receiverEntId", data.receiverEntId);
+            obj.setv("sourceEntId", data.sourceEntId);
+            obj.setv("amount", data.amount);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetDeathTimerPkt {
     public:
         static const PacketType::Id type = PacketType::SetDeathTimer;
-        static std::string name() { return "SetDeathTimer"; }
+        static const char* name() { return "SetDeathTimer"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint32_t killerEntId;
+            float timer;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x12);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("killerEntId", stream.read<uint32_t>());
+            data.killerEntId = stream.read<uint32_t>();
             stream.ignore(8);
-            data.setv("timer", stream.read<float>());
+            data.timer = stream.read<float>();
             stream.ignore(2);
 
-            return Value::create(data);
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("killerEntId", data.killerEntId);
+            obj.setv("timer", data.timer);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetHealthPkt {
     public:
         static const PacketType::Id type = PacketType::SetHealth;
-        static std::string name() { return "SetHealth"; }
+        static const char* name() { return "SetHealth"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            float maxHealth;
+            float currentHealth;
+        };
+
+        static Data decodeData(Block& block) {
             if(block.size == 0x2) { // TODO: understand this
                 throw ParseException("SetHealth: size is only 2 bytes");
             }
 
             REQUIRE(block.size == 0xa);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
             stream.ignore(2);
-            data.setv("maxHealth", stream.read<float>());
-            data.setv("currentHealth", stream.read<float>());
+            data.maxHealth = stream.read<float>();
+            data.currentHealth = stream.read<float>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("maxHealth", data.maxHealth);
+            obj.setv("currentHealth", data.currentHealth);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class AttributeGroupPkt {
     public:
         static const PacketType::Id type = PacketType::AttributeGroup;
-        static std::string name() { return "AttributeGroup"; }
+        static const char* name() { return "AttributeGroup"; }
 
-        static Value decode(Block& block) {
-            Object data = Object();
+        struct Update {
+            uint32_t entityId;
+            std::vector<EntityAttribute::Attribute> attributes; // in the order they were sent
+        };
+
+        struct Data {
+            uint32_t timestamp; // in ms from start
+            std::vector<Update> updates;
+        };
+
+        static Data decodeData(Block& block) {
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("timestamp", stream.read<uint32_t>()); // in ms from start
+            data.timestamp = stream.read<uint32_t>();
             uint8_t numUpdates = stream.read<uint8_t>();
 
-            Array updates = Array();
-            while(numUpdates--) {
-                Object update = Object();
-
+            data.updates.resize(numUpdates);
+            for(auto& update : data.updates) {
                 uint8_t groupMask = stream.get(); // defines which groups of attributes will follow
-                update.setv("entityId", stream.read<uint32_t>());
+                update.entityId = stream.read<uint32_t>();
 
-                Object attr = Object();
                 for(uint8_t groupBit = 0; groupBit < 8; groupBit++) {
                     if(!(groupMask & (1 << groupBit))) continue;
 
@@ -527,119 +938,218 @@ namespace libol {
                     for(uint8_t attrBit = 0; attrBit < 32; attrBit++) {
                         if(!(attrMask & (1 << attrBit))) continue;
 
+                        EntityAttribute::Attribute attr;
                         if(!EntityAttribute::read(&attr, stream, groupBit, attrBit)) {
                             stream.seekg(groupStart + groupSize);
                             break;
                         }
+                        update.attributes.push_back(attr);
                     }
                     if(stream.tellg() != groupStart + groupSize) // TODO: investigate
                         stream.seekg(groupStart + groupSize);
                 }
-                update.setv("attributes", attr);
+            }
+
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+
+            obj.setv("timestamp", data.timestamp);
+
+            Array updates = Array();
+            updates.reserve(data.updates.size());
+            for(auto& update : data.updates) {
+                Object updateObj = Object();
+                updateObj.reserve(2);
+                updateObj.setv("entityId", update.entityId);
+
+                Object attr = Object();
+                attr.reserve(update.attributes.size());
+                for(auto& attribute : update.attributes) {
+                    EntityAttribute::set(attr, attribute);
+                }
+                updateObj.setv("attributes", std::move(attr));
 
-                updates.pushv(update);
+                updates.pushv(std::move(updateObj));
             }
-            data.setv("updates", updates);
+            obj.setv("updates", std::move(updates));
 
-            return Value::create(data);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetTeamPkt {
     public:
         static const PacketType::Id type = PacketType::SetTeam;
-        static std::string name() { return "SetTeam"; }
+        static const char* name() { return "SetTeam"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint8_t team; // see Team
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x1);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            uint8_t teamId = stream.get();
-            data.setv("team", teamId);
-            data.setv("teamName", Team::getName(teamId));
+            data.team = stream.get();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("team", data.team);
+            obj.setv("teamName", Team::getName(data.team));
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetItemStacksPkt {
     public:
         static const PacketType::Id type = PacketType::SetItemStacks;
-        static std::string name() { return "SetItemStacks"; }
+        static const char* name() { return "SetItemStacks"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint8_t slotId;
+            uint16_t stacks;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x3);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("slotId", stream.get());
-            data.setv("stacks", stream.read<uint16_t>());
+            data.slotId = stream.get();
+            data.stacks = stream.read<uint16_t>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("slotId", data.slotId);
+            obj.setv("stacks", data.stacks);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SummonerDisconnectPkt {
     public:
         static const PacketType::Id type = PacketType::SummonerDisconnect;
-        static std::string name() { return "SummonerDisconnect"; }
+        static const char* name() { return "SummonerDisconnect"; }
 
-        static Value decode(Block& block) {
+        struct Data {
+            uint32_t entityId;
+        };
+
+        static Data decodeData(Block& block) {
             REQUIRE(block.size == 0x5);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("entityId", stream.read<uint32_t>());
+            data.entityId = stream.read<uint32_t>();
             stream.ignore(1); // unknown
 
-            return Value::create(data);
+            return data;
+        }
+
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(1);
+            obj.setv("entityId", data.entityId);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class SetLevelPkt {
     public:
         static const PacketType::Id type = PacketType::SetLevel;
-        static std::string name() { return "SetLevel"; }
+        static const char* name() { return "SetLevel"; }
 
-        static Value decode(Block &block) {
+        struct Data {
+            uint8_t level;
+            uint8_t skillPoints;
+        };
+
+        static Data decodeData(Block &block) {
             REQUIRE(block.size == 0x2);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("level", stream.read<uint8_t>());
-            data.setv("skillPoints", stream.read<uint8_t>());
+            data.level = stream.read<uint8_t>();
+            data.skillPoints = stream.read<uint8_t>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(2);
+            obj.setv("level", data.level);
+            obj.setv("skillPoints", data.skillPoints);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 
     class ChampionRespawnPkt {
     public:
         static const PacketType::Id type = PacketType::ChampionRespawn;
-        static std::string name() { return "ChampionRespawn"; }
+        static const char* name() { return "ChampionRespawn"; }
 
-        static Value decode(Block &block) {
+        struct Data {
+            float x;
+            float y;
+            float mana;
+        };
+
+        static Data decodeData(Block &block) {
             REQUIRE(block.size == 0xc);
 
-            Object data = Object();
+            Data data;
 
             auto stream = block.createStream();
 
-            data.setv("x", stream.read<float>());
-            data.setv("y", stream.read<float>());
-            data.setv("mana", stream.read<float>());
+            data.x = stream.read<float>();
+            data.y = stream.read<float>();
+            data.mana = stream.read<float>();
+
+            return data;
+        }
 
-            return Value::create(data);
+        static Value toValue(const Data& data) {
+            Object obj = Object();
+            obj.reserve(3);
+            obj.setv("x", data.x);
+            obj.setv("y", data.y);
+            obj.setv("mana", data.mana);
+            return Value::create(std::move(obj));
         }
+
+        static Value decode(Block& block) { return toValue(decodeData(block)); }
     };
 }
 
@@ -7,28 +7,43 @@
 #include "Block.h"
 #include "Packet.h"
 #include "PacketDecoders.h"
+#include "PacketVisitor.h"
 
-#include <map>
-#include <fstream>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace libol {
     class PacketParser {
         friend struct Packet;
 
         struct PacketDecoder {
-            std::function< std::string () > getName;
-            std::function< Value (Block&) > decode;
+            std::string name; // made once here, so packets can refer to it
+            Value (*decode)(Block&);
+            void (*visit)(Block&, PacketVisitor&);
         };
 
-        std::map<PacketType::Id, PacketDecoder > decoders;
+        template<class PACKET>
+        static void visitPacket(Block& block, PacketVisitor& visitor) {
+            visitor.visit(block, PACKET::decodeData(block));
+        }
+
+        // slots[type] is 1 + the type's index in decoders, or 0 if it has
+        // none, so a lookup is two array reads rather than a tree walk. A
+        // byte per type instead of a PacketDecoder keeps the table at 64k,
+        // and the number of packets at 255.
+        std::array<uint8_t, 0x10000> slots;
+        std::vector<PacketDecoder> decoders;
 
         template<class PACKET>
         void registerPacket() {
-            PacketType::Id type = PACKET::type;
-            decoders[type] = PacketDecoder({PACKET::name, PACKET::decode});
+            decoders.push_back(PacketDecoder({PACKET::name(), PACKET::decode, visitPacket<PACKET>}));
+            slots[PACKET::type] = decoders.size();
         }
 
         PacketParser() {
+            slots.fill(0);
             registerPacket<SetAbilityLevelPkt>();
             registerPacket<GoldRewardPkt>();
             registerPacket<GoldGainPkt>();
@@ -52,24 +67,39 @@ namespace libol {
             registerPacket<ChampionRespawnPkt>();
         }
 
-        Packet decode(Block& block) {
-            Packet packet;
-
-            packet.timestamp = block.time;
+        static PacketType::Id getType(Block& block) {
             if(block.type == PacketType::ExtendedType) {
                 uint16_t realType;
                 block.read(&realType, 0);
-                packet.type = realType;
-            } else
-                packet.type = block.type;
+                return realType;
+            }
+            return block.type;
+        }
+
+        // The decoder for the block, or nullptr if it isn't decoded
+        const PacketDecoder* find(Block& block, PacketType::Id type) const {
+            uint8_t slot = slots[type];
+            if(block.channel == Channel::LoadingScreen || !slot)
+                return nullptr;
+            return &decoders[slot - 1];
+        }
+
+        // const, and so safe to call from several threads at once
+        Packet decode(Block& block) const {
+            Packet packet;
+
+            packet.timestamp = block.time;
+            packet.type = getType(block);
             packet.entityId = block.entityId;
 
             packet.isDecoded = false;
-            if(block.channel != Channel::LoadingScreen && decoders.count(packet.type)) {
-                auto& decoder = decoders[packet.type];
+            const PacketDecoder* found = find(block, packet.type);
+            if(found) {
+                const PacketDecoder& decoder = *found;
                 try {
                     packet.data = decoder.decode(block);
-                    packet.typeName = decoder.getName();
+                    packet.arena = ValueArena::current();
+                    packet.name = &decoder.name;
                     packet.isDecoded = true;
                 } catch(ParseException& ex) {
                     packet.isDecoded = false;
@@ -80,8 +110,19 @@ namespace libol {
             return packet;
         }
 
-        static PacketParser& getInstance() {
-            static PacketParser instance;
+        bool visit(Block& block, PacketVisitor& visitor) const {
+            PacketType::Id type = getType(block);
+            const PacketDecoder* found = find(block, type);
+            if(!found) {
+                visitor.visitUnknown(block, type);
+                return false;
+            }
+            found->visit(block, visitor);
+            return true;
+        }
+
+        static const PacketParser& getInstance() {
+            static const PacketParser instance;
             return instance;
         }
     };
@@ -0,0 +1,17 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "PacketStream.h"
+#include "ByteSource.h"
+
+namespace libol {
+    void PacketStream::run(std::ifstream& ifs) {
+        FileSource source(ifs);
+        run(source);
+    }
+
+    void PacketStream::run(const uint8_t* data, size_t len) {
+        MemorySource source(ByteSpan(data, len));
+        run(source);
+    }
+}
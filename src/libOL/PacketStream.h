@@ -0,0 +1,106 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__PacketStream__
+#define __libol__PacketStream__
+
+#include "Block.h"
+#include "BlockFilter.h"
+#include "BlockReader.h"
+#include "Constants.h"
+#include "PacketDecoders.h"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace libol {
+    // Reads blocks and hands the packets of the subscribed types to their
+    // handlers as they're read, as the packet's Data struct (see
+    // PacketDecoders.h):
+    //     PacketStream stream;
+    //     stream.on<DamageDonePkt>([] (Block& block, const DamageDonePkt::Data& data) { ... });
+    //     stream.run(ifs);
+    // Blocks of other types only have their headers read, and nothing is
+    // decoded for them. Handlers run in the order they were added.
+    class PacketStream {
+        struct Subscribers {
+            virtual ~Subscribers() {}
+            virtual void dispatch(Block& block) = 0;
+        };
+
+        // Decodes the block once for all of its type's handlers
+        template<class PACKET>
+        struct PacketSubscribers : Subscribers {
+            std::vector<std::function<void (Block&, const typename PACKET::Data&)>> handlers;
+
+            void dispatch(Block& block) {
+                typename PACKET::Data data = PACKET::decodeData(block);
+                for (auto& handler : handlers) {
+                    handler(block, data);
+                }
+            }
+        };
+
+        std::map<PacketType::Id, std::unique_ptr<Subscribers>> subscribers;
+        BlockFilter filter; // the subscribed types
+
+    public:
+        // Carries the delta state from one run to the next, so the chunks of
+        // a game can be fed in order
+        BlockReader reader;
+
+        // ExtendedType itself is never a real type, so adding it just stops
+        // a stream with no subscribers from matching everything
+        PacketStream() : filter(BlockFilter().addType(PacketType::ExtendedType)) {}
+
+        template<class PACKET>
+        PacketStream& on(std::function<void (Block&, const typename PACKET::Data&)> handler) {
+            PacketType::Id type = PACKET::type;
+            std::unique_ptr<Subscribers>& entry = subscribers[type];
+            if (!entry) {
+                entry.reset(new PacketSubscribers<PACKET>());
+                filter.addType(type);
+            }
+            static_cast<PacketSubscribers<PACKET>&>(*entry).handlers.push_back(std::move(handler));
+            return *this;
+        }
+
+        /**
+         * Reads every block in source, dispatching the subscribed ones. A
+         * block that fails to decode stops the run with source just after
+         * it and the reader's state updated, so calling run again carries on
+         * from the next block.
+         * \throws ParseException if a subscribed block or the source is malformed
+         */
+        template<class Source>
+        void run(Source& source) {
+            Block block;
+            while (reader.next(source, block, filter)) {
+                if (block.channel == Channel::LoadingScreen) {
+                    continue; // never decoded, as in Packet::decode
+                }
+
+                PacketType::Id type = block.type;
+                if (type == PacketType::ExtendedType) {
+                    block.read(&type, 0);
+                }
+                auto found = subscribers.find(type);
+                if (found != subscribers.end()) {
+                    found->second->dispatch(block);
+                }
+            }
+        }
+
+        // A stream of blocks, as written by the blocks command; ifs is left after the last block read
+        void run(std::ifstream& ifs);
+
+        // A decrypted chunk
+        void run(const uint8_t* data, size_t len);
+    };
+}
+
+#endif /* defined(__libol__PacketStream__) */
@@ -0,0 +1,46 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__PacketVisitor__
+#define __libol__PacketVisitor__
+
+#include "Block.h"
+#include "PacketDecoders.h"
+
+namespace libol {
+    // Receives a block's packet as its plain Data struct, without building a
+    // Value tree, see Packet::visit. Override the overloads for the packets
+    // you want; the rest do nothing. block is the one being visited, for its
+    // time and entityId, and data only lasts for the call.
+    class PacketVisitor {
+    public:
+        virtual ~PacketVisitor() {}
+
+        virtual void visit(Block&, const SetAbilityLevelPkt::Data&) {}
+        virtual void visit(Block&, const GoldRewardPkt::Data&) {}
+        virtual void visit(Block&, const GoldGainPkt::Data&) {}
+        virtual void visit(Block&, const SetInventoryPkt::Data&) {}
+        virtual void visit(Block&, const ItemPurchasePkt::Data&) {}
+        virtual void visit(Block&, const ChampionSpawnPkt::Data&) {}
+        virtual void visit(Block&, const SummonerDataPkt::Data&) {}
+        virtual void visit(Block&, const PlayerStatsPkt::Data&) {}
+        virtual void visit(Block&, const MovementGroupPkt::Data&) {}
+        virtual void visit(Block&, const SetOwnershipPkt::Data&) {}
+        virtual void visit(Block&, const AttentionPingPkt::Data&) {}
+        virtual void visit(Block&, const PlayEmotePkt::Data&) {}
+        virtual void visit(Block&, const DamageDonePkt::Data&) {}
+        virtual void visit(Block&, const SetDeathTimerPkt::Data&) {}
+        virtual void visit(Block&, const SetHealthPkt::Data&) {}
+        virtual void visit(Block&, const AttributeGroupPkt::Data&) {}
+        virtual void visit(Block&, const SetTeamPkt::Data&) {}
+        virtual void visit(Block&, const SetItemStacksPkt::Data&) {}
+        virtual void visit(Block&, const SummonerDisconnectPkt::Data&) {}
+        virtual void visit(Block&, const SetLevelPkt::Data&) {}
+        virtual void visit(Block&, const ChampionRespawnPkt::Data&) {}
+
+        // Blocks with no decoder for their type, or on the loading screen channel
+        virtual void visitUnknown(Block&, PacketType::Id) {}
+    };
+}
+
+#endif /* defined(__libol__PacketVisitor__) */
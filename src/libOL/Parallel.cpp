@@ -0,0 +1,40 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace libol {
+    namespace Parallel {
+        unsigned getThreadCount(unsigned threadCount, size_t pieces) {
+            if (threadCount == 0) {
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+            }
+            return (unsigned) std::max<size_t>(1, std::min<size_t>(threadCount, pieces));
+        }
+
+        void run(unsigned threadCount, std::atomic<bool>& stop, const std::function<void ()>& work) {
+            std::vector<std::thread> workers;
+            workers.reserve(threadCount); // so adding a started thread can't throw
+            try {
+                for (unsigned i = 1; i < threadCount; i++) {
+                    workers.push_back(std::thread(work));
+                }
+            } catch (...) {
+                // out of threads: stop the ones already running before giving up
+                stop = true;
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+                throw;
+            }
+            work(); // the calling thread takes a share too
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+    }
+}
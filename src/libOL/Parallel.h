@@ -0,0 +1,30 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__Parallel__
+#define __libol__Parallel__
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace libol {
+    // The worker threads behind the parallel decodes: the work is split by
+    // the workers themselves, each pulling the next piece until none are left.
+    namespace Parallel {
+        // Threads worth running for the given number of pieces: threadCount,
+        // or one per core if it's 0, but no more than there are pieces and at least one
+        unsigned getThreadCount(unsigned threadCount, size_t pieces);
+
+        /**
+         * Runs work on threadCount - 1 new threads and on the calling thread,
+         * returning once it has finished on all of them. work should stop
+         * picking up pieces once stop is set.
+         * \throws std::system_error if a thread can't be started; stop is set
+         * and the threads already running are joined first
+         */
+        void run(unsigned threadCount, std::atomic<bool>& stop, const std::function<void ()>& work);
+    }
+}
+
+#endif /* defined(__libol__Parallel__) */
@@ -4,32 +4,35 @@
 #include "PayloadHeader.h"
 
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 
 #include "Blowfish/Blowfish.h"
+#include "ByteSource.h"
 
-static inline std::vector<uint8_t> b64Decode(std::string const& input) {
-    if (input.length() == 0) {
+static inline std::vector<uint8_t> b64Decode(const char* input, size_t length) {
+    if (length == 0) {
         return std::vector<uint8_t>();
     }
-    assert(input.length() % 4 == 0);
+    assert(length % 4 == 0);
 
     size_t padding = 0;
-    if (input[input.size() - 1] == '=') {
+    if (input[length - 1] == '=') {
         padding++;
     }
-    if (input[input.size() - 1] == '=') {
+    if (input[length - 1] == '=') {
         padding++;
     }
 
     std::vector<uint8_t> result;
-    result.reserve(3 * (input.length() / 4) - padding);
+    result.reserve(3 * (length / 4) - padding);
 
+    const char* end = input + length;
     int decodedBytes = 0;
     uint32_t bytes = 0;
-    for (auto cursor = input.begin(); cursor < input.end(); cursor++) {
+    for (auto cursor = input; cursor < end; cursor++) {
         char character = *cursor;
         if (character >= 'A' && character <= 'Z') {
             bytes |= character - 'A';
@@ -42,7 +45,7 @@ static inline std::vector<uint8_t> b64Decode(std::string const& input) {
         } else if (character == '/') {
             bytes |= 63;
         } else if (character == '=') {
-            auto fromEnd = input.end() - cursor;
+            auto fromEnd = end - cursor;
             if (fromEnd == 1) {
                 result.push_back((bytes >> 16) & 0xff);
                 result.push_back((bytes >> 8) & 0xff);
@@ -69,29 +72,52 @@ static inline std::vector<uint8_t> b64Decode(std::string const& input) {
 
 namespace libol {
     std::vector<uint8_t> PayloadHeader::getDecodedEncryptionKey() {
-        auto encryptedKeyBytes = b64Decode(this->encryptionKey);
+        return decodeEncryptionKey(encryptionKey.data(), encryptionKey.size(), gameId);
+    }
+
+    std::vector<uint8_t> PayloadHeader::decodeEncryptionKey(const char* encryptionKey, size_t length, uint64_t gameId) {
+        auto keyBytes = b64Decode(encryptionKey, length);
 
         auto gameIdStr = std::to_string(gameId);
-        auto gameIdVec = std::vector<uint8_t>{gameIdStr.begin(), gameIdStr.end()};
+        Blowfish::KeySchedule gameIdKey(reinterpret_cast<const uint8_t*>(gameIdStr.data()), gameIdStr.size());
 
-        std::vector<uint8_t> out = Blowfish::decrypt(encryptedKeyBytes, gameIdVec);
+        keyBytes.resize(Blowfish::decryptInPlace(keyBytes.data(), keyBytes.size(), gameIdKey));
 
-        return out;
+        return keyBytes;
     }
 
-    PayloadHeader PayloadHeader::decode(std::ifstream& ifs) {
+    template<class Source>
+    PayloadHeader PayloadHeader::decode(Source& source) {
+        MemorySource record(source.readSpan(ROFL_PAYLOAD_HEADER_LENGTH));
         PayloadHeader payloadHeader;
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.gameId), sizeof(payloadHeader.gameId));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.gameLength), sizeof(payloadHeader.gameLength));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.keyframeCount), sizeof(payloadHeader.keyframeCount));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.chunkCount), sizeof(payloadHeader.chunkCount));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.endStartupChunkId), sizeof(payloadHeader.endStartupChunkId));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.startGameChunkId), sizeof(payloadHeader.startGameChunkId));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.keyframeInterval), sizeof(payloadHeader.keyframeInterval));
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.encryptionKeyLength), sizeof(payloadHeader.encryptionKeyLength));
-
-        payloadHeader.encryptionKey.resize(payloadHeader.encryptionKeyLength);
-        ifs.read(reinterpret_cast<char *>(&payloadHeader.encryptionKey[0]), payloadHeader.encryptionKeyLength);
+        record.read(&payloadHeader.gameId);
+        record.read(&payloadHeader.gameLength);
+        record.read(&payloadHeader.keyframeCount);
+        record.read(&payloadHeader.chunkCount);
+        record.read(&payloadHeader.endStartupChunkId);
+        record.read(&payloadHeader.startGameChunkId);
+        record.read(&payloadHeader.keyframeInterval);
+        record.read(&payloadHeader.encryptionKeyLength);
+
+        ByteSpan key = source.readSpan(payloadHeader.encryptionKeyLength);
+        payloadHeader.encryptionKey.assign(key.begin(), key.end());
         return payloadHeader;
     }
+
+#define INSTANTIATE(Source) template PayloadHeader PayloadHeader::decode<Source>(Source&);
+    LIBOL_FOR_EACH_BYTE_SOURCE(INSTANTIATE)
+#undef INSTANTIATE
+
+    PayloadHeader PayloadHeader::decode(std::ifstream& ifs) {
+        // the fixed-size part ends with the key's length
+        std::vector<uint8_t> record(ROFL_PAYLOAD_HEADER_LENGTH);
+        readFromStream(ifs, record.data(), record.size());
+        uint16_t keyLength;
+        memcpy(&keyLength, record.data() + ROFL_PAYLOAD_HEADER_LENGTH - sizeof(keyLength), sizeof(keyLength));
+        record.resize(ROFL_PAYLOAD_HEADER_LENGTH + keyLength);
+        readFromStream(ifs, record.data() + ROFL_PAYLOAD_HEADER_LENGTH, keyLength);
+
+        MemorySource source(ByteSpan(record.data(), record.size()));
+        return decode(source);
+    }
 }
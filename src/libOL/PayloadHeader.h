@@ -8,6 +8,9 @@
 #include <iostream>
 #include <vector>
 
+// Fixed-size part, before the encryption key
+#define ROFL_PAYLOAD_HEADER_LENGTH 34
+
 namespace libol {
     class PayloadHeader {
     public:
@@ -23,6 +26,13 @@ namespace libol {
 
         std::vector<uint8_t> getDecodedEncryptionKey();
 
+        // Base64-decodes and decrypts a chunk key as stored in the payload header
+        static std::vector<uint8_t> decodeEncryptionKey(const char* encryptionKey, size_t length, uint64_t gameId);
+
+        // Reads the fixed-size part at once, see ByteSource.h
+        template<class Source>
+        static PayloadHeader decode(Source& source);
+
         static PayloadHeader decode(std::ifstream& ifs);
     };
 }
@@ -3,30 +3,35 @@
 
 #include "Rofl.h"
 
+#include <algorithm>
 #include <fstream>
+#include <utility>
 
+#include "BufferPool.h"
+#include "ByteSource.h"
 #include "Chunks.h"
 
 namespace libol {
     Rofl Rofl::decode(std::ifstream& ifs) {
         Rofl file;
+        FileSource source(ifs);
 
         // Header
-        file.header = Header::decode(ifs);
+        file.header = Header::decode(source);
 
         // Metadata
-        ifs.seekg(file.header.metadataOffset);
+        source.seek(file.header.metadataOffset);
         file.metadata.resize(file.header.metadataLength);
-        ifs.read(reinterpret_cast<char *>(&file.metadata[0]), file.header.metadataLength);
+        source.read(&file.metadata[0], file.header.metadataLength);
 
         // Payload Header
-        ifs.seekg(file.header.payloadHeaderOffset);
-        file.payloadHeader = PayloadHeader::decode(ifs);
+        source.seek(file.header.payloadHeaderOffset);
+        file.payloadHeader = PayloadHeader::decode(source);
 
         // Chunk and Keyframe headers
-        ifs.seekg(file.header.payloadHeaderOffset + file.header.payloadHeaderLength);
-        file.chunkHeaders = ChunkHeader::decodeMultiple(ifs, file.payloadHeader.chunkCount);
-        file.keyframeHeaders = ChunkHeader::decodeMultiple(ifs, file.payloadHeader.keyframeCount);
+        source.seek(file.header.payloadHeaderOffset + file.header.payloadHeaderLength);
+        file.chunkHeaders = ChunkHeader::decodeMultiple(source, file.payloadHeader.chunkCount);
+        file.keyframeHeaders = ChunkHeader::decodeMultiple(source, file.payloadHeader.keyframeCount);
 
         return file;
     }
@@ -39,15 +44,135 @@ namespace libol {
     }
 
     std::vector<uint8_t> Rofl::getDecryptedChunk(std::ifstream& ifs, ChunkHeader chunkHeader) {
-        std::vector<uint8_t> chunk;
+        ChunkDecoder decoder = createChunkDecoder();
+        return getDecryptedChunk(ifs, chunkHeader, decoder);
+    }
+
+    std::vector<uint8_t> Rofl::getDecryptedChunk(std::ifstream& ifs, ChunkHeader chunkHeader, ChunkDecoder& decoder) {
+        std::vector<uint8_t> chunk = BufferPool::acquire(chunkHeader.chunkLength);
         chunk.resize(chunkHeader.chunkLength);
 
         seekToChunk(ifs, chunkHeader);
         ifs.read(reinterpret_cast<char *>(&chunk[0]), chunkHeader.chunkLength);
 
-        auto decryptionKey = payloadHeader.getDecodedEncryptionKey();
-        auto decrypted = libol::Chunks::decryptAndDecompress(chunk, decryptionKey);
+        auto decrypted = decoder.decode(chunk);
+        BufferPool::release(std::move(chunk));
         return decrypted;
     }
 
+    ChunkDecoder Rofl::createChunkDecoder() {
+        return ChunkDecoder(payloadHeader.getDecodedEncryptionKey());
+    }
+
+    std::vector<Chunks::DecryptedChunk> Rofl::getDecryptedChunks(std::ifstream& ifs, std::vector<ChunkHeader> chunkHeaders, unsigned threadCount) {
+        std::vector<std::vector<uint8_t>> buffers(chunkHeaders.size());
+        std::vector<Chunks::EncryptedChunk> chunks;
+        chunks.reserve(chunkHeaders.size());
+        for (size_t i = 0; i < chunkHeaders.size(); i++) {
+            buffers[i].resize(chunkHeaders[i].chunkLength);
+            seekToChunk(ifs, chunkHeaders[i]);
+            ifs.read(reinterpret_cast<char *>(buffers[i].data()), chunkHeaders[i].chunkLength);
+            chunks.push_back(Chunks::EncryptedChunk {chunkHeaders[i].chunkId, ByteSpan(buffers[i].data(), buffers[i].size())});
+        }
+
+        auto decryptionKey = payloadHeader.getDecodedEncryptionKey();
+        return libol::Chunks::decryptAndDecompressParallel(chunks, decryptionKey, threadCount);
+    }
+
+    std::vector<Chunks::DecryptedChunk> Rofl::getDecryptedChunks(std::ifstream& ifs, unsigned threadCount) {
+        return getDecryptedChunks(ifs, chunkHeaders, threadCount);
+    }
+
+    ChunkCache::ChunkPtr Rofl::getCachedChunk(std::ifstream& ifs, ChunkHeader chunkHeader, ChunkDecoder& decoder, ChunkCache& cache) {
+        return cache.getOrDecode(payloadHeader.gameId, chunkHeader.chunkId, [&] () {
+            return getDecryptedChunk(ifs, chunkHeader, decoder);
+        });
+    }
+
+    std::vector<BlockReader::Checkpoint> Rofl::getChunkCheckpoints(std::ifstream& ifs, unsigned threadCount) {
+        std::vector<BlockReader::Checkpoint> checkpoints;
+        checkpoints.reserve(chunkHeaders.size());
+
+        // a window of chunks at a time keeps the decoded chunks from piling up
+        BlockReader reader;
+        for (size_t first = 0; first < chunkHeaders.size(); first += ROFL_CHECKPOINT_SCAN_WINDOW) {
+            size_t last = std::min<size_t>(first + ROFL_CHECKPOINT_SCAN_WINDOW, chunkHeaders.size());
+            std::vector<ChunkHeader> window(chunkHeaders.begin() + first, chunkHeaders.begin() + last);
+            for (auto& chunk : getDecryptedChunks(ifs, window, threadCount)) {
+                checkpoints.push_back(reader.checkpoint());
+                reader.skipBuffer(chunk.bytes.data(), chunk.bytes.size());
+                BufferPool::release(std::move(chunk.bytes));
+            }
+        }
+
+        return checkpoints;
+    }
+
+    SeekResult Rofl::seekToTime(std::ifstream& ifs, float seconds, const std::vector<BlockReader::Checkpoint>& checkpoints) {
+        SeekResult result;
+        result.hasKeyframe = !keyframeHeaders.empty();
+        result.nextChunkIndex = 0;
+
+        ChunkDecoder decoder = createChunkDecoder();
+
+        if (result.hasKeyframe) {
+            size_t index = getKeyframeIndex(seconds, payloadHeader.keyframeInterval, keyframeHeaders.size());
+            result.keyframe = keyframeHeaders[index];
+
+            auto keyframe = getDecryptedChunk(ifs, result.keyframe, decoder);
+            if (!keyframe.empty()) {
+                BlockReader reader;
+                result.keyframeBlocks = reader.readBlocksFromBuffer(keyframe.data(), keyframe.size());
+            }
+            BufferPool::release(std::move(keyframe));
+
+            // the chunk table is in chunk id order
+            auto nextChunk = std::lower_bound(chunkHeaders.begin(), chunkHeaders.end(), result.keyframe.nextChunkId,
+                                              [] (const ChunkHeader& header, int32_t chunkId) {
+                return header.chunkId < chunkId;
+            });
+            result.nextChunkIndex = nextChunk - chunkHeaders.begin();
+        }
+
+        BlockReader reader;
+        SeekState state(result.nextChunkIndex < checkpoints.size());
+        if (state.timeKnown) {
+            reader.restore(checkpoints[result.nextChunkIndex]);
+        }
+        while (result.nextChunkIndex < chunkHeaders.size()) {
+            auto chunk = getDecryptedChunk(ifs, chunkHeaders[result.nextChunkIndex++], decoder);
+            bool reached = collectSeekBlocks(chunk, reader, seconds, result, state);
+            BufferPool::release(std::move(chunk));
+            if (reached) {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    size_t Rofl::getKeyframeIndex(float seconds, uint32_t keyframeInterval, uint32_t keyframeCount) {
+        if (keyframeCount == 0 || keyframeInterval == 0 || !(seconds > 0)) {
+            return 0;
+        }
+        double index = seconds * 1000.0 / keyframeInterval;
+        return index < keyframeCount ? (size_t) index : keyframeCount - 1;
+    }
+
+    bool Rofl::collectSeekBlocks(std::vector<uint8_t>& chunk, BlockReader& reader, float seconds, SeekResult& result, SeekState& state) {
+        if (chunk.empty()) {
+            return false;
+        }
+
+        bool reached = false;
+        // only the blocks that are kept need a copy of their payload, the chunk is released after this
+        for (auto& block : reader.blockViews(chunk.data(), chunk.size())) {
+            if (state.update(block.header) && block.time >= seconds) {
+                block.makeOwning();
+                result.blocks.push_back(std::move(block));
+                reached = true;
+            }
+        }
+        return reached;
+    }
 }
@@ -8,14 +8,46 @@
 #include <iostream>
 #include <vector>
 
+#include <libOL/Block.h>
+#include <libOL/BlockReader.h>
+#include <libOL/ChunkCache.h>
+#include <libOL/ChunkDecoder.h>
 #include <libOL/ChunkHeader.h>
+#include <libOL/Chunks.h>
 #include <libOL/Header.h>
 #include <libOL/PayloadHeader.h>
 
-#define ROFL_CHUNK_HEADER_LENGTH 17
-#define ROFL_KEYFRAME_HEADER_LENGTH 17
+// Chunks decoded per round when scanning for checkpoints, see Rofl::getChunkCheckpoints
+#define ROFL_CHECKPOINT_SCAN_WINDOW 16
 
 namespace libol {
+    // What playback from a point in time needs, see Rofl::seekToTime
+    struct SeekResult {
+        bool hasKeyframe;
+        ChunkHeader keyframe;              // last keyframe at or before the requested time
+        std::vector<Block> keyframeBlocks; // the keyframe's state snapshot
+        std::vector<Block> blocks;         // blocks from the requested time to the end of its chunk
+        size_t nextChunkIndex;             // chunk table index to carry on decoding from
+    };
+
+    // Which parts of a seek's delta state are known to be right; they start
+    // out unknown when there's no checkpoint to read from, see Rofl::seekToTime
+    struct SeekState {
+        bool timeKnown;
+        bool typeKnown;
+        bool entityIdKnown;
+
+        explicit SeekState(bool known) : timeKnown(known), typeKnown(known), entityIdKnown(known) {}
+
+        // Takes in what the block sets outright, returns whether all of its fields are now right
+        bool update(const Block::BlockHeader& header) {
+            timeKnown = timeKnown || header.timeIsAbs;
+            typeKnown = typeKnown || header.hasExplicitType;
+            entityIdKnown = entityIdKnown || header.paramIs32;
+            return timeKnown && typeKnown && entityIdKnown;
+        }
+    };
+
     class Rofl {
     public:
         Header header;
@@ -26,6 +58,47 @@ namespace libol {
 
         void seekToChunk(std::ifstream& ifs, ChunkHeader chunkHeader);
         std::vector<uint8_t> getDecryptedChunk(std::ifstream& ifs, ChunkHeader chunkHeader);
+        std::vector<uint8_t> getDecryptedChunk(std::ifstream& ifs, ChunkHeader chunkHeader, ChunkDecoder& decoder);
+
+        // Session that derives the chunk key once, for decoding many chunks in a row
+        ChunkDecoder createChunkDecoder();
+
+        // Looks the chunk up in the cache first, decoding and caching it on a miss
+        ChunkCache::ChunkPtr getCachedChunk(std::ifstream& ifs, ChunkHeader chunkHeader, ChunkDecoder& decoder, ChunkCache& cache);
+
+        // Reads the given chunks (or all of them) serially, then decodes them across threadCount threads
+        std::vector<Chunks::DecryptedChunk> getDecryptedChunks(std::ifstream& ifs, std::vector<ChunkHeader> chunkHeaders, unsigned threadCount = 0);
+        std::vector<Chunks::DecryptedChunk> getDecryptedChunks(std::ifstream& ifs, unsigned threadCount = 0);
+
+        /**
+         * Reader state at the start of each chunk, in chunk table order, as if
+         * they were all read through one BlockReader. A chunk read by a
+         * BlockReader restored to its checkpoint gives the same blocks as the
+         * serial read, so chunks can be handed out to separate workers.
+         * Chunks are decoded ROFL_CHECKPOINT_SCAN_WINDOW at a time, across
+         * threadCount threads, and only their block headers are scanned.
+         */
+        std::vector<BlockReader::Checkpoint> getChunkCheckpoints(std::ifstream& ifs, unsigned threadCount = 0);
+
+        /**
+         * Decodes only the keyframe before the given time and the chunks
+         * following it up to the chunk containing that time. The chunks
+         * carry delta state over from the ones before them: with checkpoints
+         * from getChunkCheckpoints, they're read as they would be straight
+         * through. Without, reading starts from zero state, and blocks are
+         * left out until the time, type and entity id have each been set
+         * outright by a block, so every block returned is as it would be
+         * straight through. Some at or after the time may be lost that way.
+         */
+        SeekResult seekToTime(std::ifstream& ifs, float seconds,
+                              const std::vector<BlockReader::Checkpoint>& checkpoints = std::vector<BlockReader::Checkpoint>());
+
+        // Index of the last keyframe at or before the given time, keyframes are keyframeInterval ms apart
+        static size_t getKeyframeIndex(float seconds, uint32_t keyframeInterval, uint32_t keyframeCount);
+
+        // Appends the chunk's blocks at or after the seek time, returns true once the time has been reached.
+        // Blocks are skipped until state knows the reader's time, type and entity id are right.
+        static bool collectSeekBlocks(std::vector<uint8_t>& chunk, BlockReader& reader, float seconds, SeekResult& result, SeekState& state);
 
         static Rofl decode(std::ifstream& ifs);
     };
@@ -0,0 +1,183 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "RoflView.h"
+#include "BufferPool.h"
+#include "ByteSource.h"
+#include "Chunks.h"
+#include "Rofl.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace libol {
+    std::vector<uint8_t> RoflView::PayloadHeaderView::getDecodedEncryptionKey() const {
+        return PayloadHeader::decodeEncryptionKey(reinterpret_cast<const char*>(encryptionKey.data),
+                                                  encryptionKey.size, gameId);
+    }
+
+    RoflView::RoflView(MappedFile&& mapped) : file(std::move(mapped)) {
+        ByteSpan span = file.span();
+        MemorySource source(span);
+
+        // Header
+        header = Header::decode(source);
+
+        // Metadata
+        metadata = span.subspan(header.metadataOffset, header.metadataLength);
+
+        // Payload Header
+        MemorySource payloadHeaderSource(span.subspan(header.payloadHeaderOffset, header.payloadHeaderLength));
+        payloadHeaderSource.read(&payloadHeader.gameId);
+        payloadHeaderSource.read(&payloadHeader.gameLength);
+        payloadHeaderSource.read(&payloadHeader.keyframeCount);
+        payloadHeaderSource.read(&payloadHeader.chunkCount);
+        payloadHeaderSource.read(&payloadHeader.endStartupChunkId);
+        payloadHeaderSource.read(&payloadHeader.startGameChunkId);
+        payloadHeaderSource.read(&payloadHeader.keyframeInterval);
+        payloadHeaderSource.read(&payloadHeader.encryptionKeyLength);
+        payloadHeader.encryptionKey = payloadHeaderSource.readSpan(payloadHeader.encryptionKeyLength);
+
+        // Chunk and Keyframe headers
+        size_t tablesOffset = header.payloadHeaderOffset + header.payloadHeaderLength;
+        size_t chunkTableLength = (size_t) payloadHeader.chunkCount * ROFL_CHUNK_HEADER_LENGTH;
+        size_t keyframeTableLength = (size_t) payloadHeader.keyframeCount * ROFL_KEYFRAME_HEADER_LENGTH;
+        chunkHeaderTable = span.subspan(tablesOffset, chunkTableLength);
+        keyframeHeaderTable = span.subspan(tablesOffset + chunkTableLength, keyframeTableLength);
+
+        // Chunk data, see Rofl::seekToChunk
+        size_t payloadStart = (size_t) header.payloadOffset + chunkTableLength + keyframeTableLength;
+        REQUIRE(payloadStart <= span.size);
+        payload = span.subspan(payloadStart, span.size - payloadStart);
+    }
+
+    ChunkHeader RoflView::getChunkHeader(size_t index) const {
+        REQUIRE(index < payloadHeader.chunkCount);
+        MemorySource source(chunkHeaderTable, index * ROFL_CHUNK_HEADER_LENGTH);
+        return ChunkHeader::decode(source);
+    }
+
+    ChunkHeader RoflView::getKeyframeHeader(size_t index) const {
+        REQUIRE(index < payloadHeader.keyframeCount);
+        MemorySource source(keyframeHeaderTable, index * ROFL_KEYFRAME_HEADER_LENGTH);
+        return ChunkHeader::decode(source);
+    }
+
+    ByteSpan RoflView::getChunkData(const ChunkHeader& chunkHeader) const {
+        REQUIRE(chunkHeader.offset >= 0 && chunkHeader.chunkLength >= 0);
+        return payload.subspan(chunkHeader.offset, chunkHeader.chunkLength);
+    }
+
+    std::vector<uint8_t> RoflView::getDecryptedChunk(const ChunkHeader& chunkHeader) const {
+        ChunkDecoder decoder = createChunkDecoder();
+        return getDecryptedChunk(chunkHeader, decoder);
+    }
+
+    std::vector<uint8_t> RoflView::getDecryptedChunk(const ChunkHeader& chunkHeader, ChunkDecoder& decoder) const {
+        return decoder.decode(getChunkData(chunkHeader));
+    }
+
+    ChunkDecoder RoflView::createChunkDecoder() const {
+        return ChunkDecoder(payloadHeader.getDecodedEncryptionKey());
+    }
+
+    ChunkCache::ChunkPtr RoflView::getCachedChunk(const ChunkHeader& chunkHeader, ChunkDecoder& decoder, ChunkCache& cache) const {
+        return cache.getOrDecode(payloadHeader.gameId, chunkHeader.chunkId, [&] () {
+            return getDecryptedChunk(chunkHeader, decoder);
+        });
+    }
+
+    std::vector<Chunks::DecryptedChunk> RoflView::getDecryptedChunks(const std::vector<ChunkHeader>& chunkHeaders, unsigned threadCount) const {
+        std::vector<Chunks::EncryptedChunk> chunks;
+        chunks.reserve(chunkHeaders.size());
+        for (auto& chunkHeader : chunkHeaders) {
+            chunks.push_back(Chunks::EncryptedChunk {chunkHeader.chunkId, getChunkData(chunkHeader)});
+        }
+
+        auto decryptionKey = payloadHeader.getDecodedEncryptionKey();
+        return libol::Chunks::decryptAndDecompressParallel(chunks, decryptionKey, threadCount);
+    }
+
+    std::vector<Chunks::DecryptedChunk> RoflView::getDecryptedChunks(unsigned threadCount) const {
+        std::vector<ChunkHeader> chunkHeaders;
+        chunkHeaders.reserve(payloadHeader.chunkCount);
+        for (size_t i = 0; i < payloadHeader.chunkCount; i++) {
+            chunkHeaders.push_back(getChunkHeader(i));
+        }
+        return getDecryptedChunks(chunkHeaders, threadCount);
+    }
+
+    std::vector<BlockReader::Checkpoint> RoflView::getChunkCheckpoints(unsigned threadCount) const {
+        std::vector<BlockReader::Checkpoint> checkpoints;
+        checkpoints.reserve(payloadHeader.chunkCount);
+
+        // a window of chunks at a time keeps the decoded chunks from piling up
+        BlockReader reader;
+        for (size_t first = 0; first < payloadHeader.chunkCount; first += ROFL_CHECKPOINT_SCAN_WINDOW) {
+            size_t last = std::min<size_t>(first + ROFL_CHECKPOINT_SCAN_WINDOW, payloadHeader.chunkCount);
+            std::vector<ChunkHeader> window;
+            for (size_t i = first; i < last; i++) {
+                window.push_back(getChunkHeader(i));
+            }
+            for (auto& chunk : getDecryptedChunks(window, threadCount)) {
+                checkpoints.push_back(reader.checkpoint());
+                reader.skipBuffer(chunk.bytes.data(), chunk.bytes.size());
+                BufferPool::release(std::move(chunk.bytes));
+            }
+        }
+
+        return checkpoints;
+    }
+
+    SeekResult RoflView::seekToTime(float seconds, const std::vector<BlockReader::Checkpoint>& checkpoints) const {
+        SeekResult result;
+        result.hasKeyframe = payloadHeader.keyframeCount > 0;
+        result.nextChunkIndex = 0;
+
+        ChunkDecoder decoder = createChunkDecoder();
+
+        if (result.hasKeyframe) {
+            size_t index = Rofl::getKeyframeIndex(seconds, payloadHeader.keyframeInterval, payloadHeader.keyframeCount);
+            result.keyframe = getKeyframeHeader(index);
+
+            auto keyframe = getDecryptedChunk(result.keyframe, decoder);
+            if (!keyframe.empty()) {
+                BlockReader reader;
+                result.keyframeBlocks = reader.readBlocksFromBuffer(keyframe.data(), keyframe.size());
+            }
+            BufferPool::release(std::move(keyframe));
+
+            // binary search the chunk table, which is in chunk id order
+            size_t low = 0, high = payloadHeader.chunkCount;
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+                if (getChunkHeader(middle).chunkId < result.keyframe.nextChunkId) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            result.nextChunkIndex = low;
+        }
+
+        BlockReader reader;
+        SeekState state(result.nextChunkIndex < checkpoints.size());
+        if (state.timeKnown) {
+            reader.restore(checkpoints[result.nextChunkIndex]);
+        }
+        while (result.nextChunkIndex < payloadHeader.chunkCount) {
+            auto chunk = getDecryptedChunk(getChunkHeader(result.nextChunkIndex++), decoder);
+            bool reached = Rofl::collectSeekBlocks(chunk, reader, seconds, result, state);
+            BufferPool::release(std::move(chunk));
+            if (reached) {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    RoflView RoflView::open(const std::string& path) {
+        return RoflView(MappedFile(path));
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__RoflView__
+#define __libol__RoflView__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <libOL/ByteSpan.h>
+#include <libOL/ChunkCache.h>
+#include <libOL/ChunkDecoder.h>
+#include <libOL/ChunkHeader.h>
+#include <libOL/Chunks.h>
+#include <libOL/Header.h>
+#include <libOL/MappedFile.h>
+#include <libOL/PayloadHeader.h>
+#include <libOL/Rofl.h>
+
+namespace libol {
+    // Zero-copy alternative to Rofl: maps the replay once and hands out spans
+    // into the mapping instead of reading each section into its own buffer.
+    // Opening a view doesn't allocate; the chunk and keyframe tables are
+    // decoded on demand from their packed on-disk records.
+    class RoflView {
+        MappedFile file;
+
+        explicit RoflView(MappedFile&& file);
+    public:
+        struct PayloadHeaderView {
+            uint64_t gameId;
+            uint32_t gameLength;
+            uint32_t keyframeCount;
+            uint32_t chunkCount;
+            uint32_t endStartupChunkId;
+            uint32_t startGameChunkId;
+            uint32_t keyframeInterval;
+            uint16_t encryptionKeyLength;
+            ByteSpan encryptionKey;
+
+            std::vector<uint8_t> getDecodedEncryptionKey() const;
+        };
+
+        Header header;
+        ByteSpan metadata;
+        PayloadHeaderView payloadHeader;
+        ByteSpan chunkHeaderTable;    // payloadHeader.chunkCount packed records
+        ByteSpan keyframeHeaderTable; // payloadHeader.keyframeCount packed records
+        ByteSpan payload;             // chunk and keyframe data, addressed by ChunkHeader::offset
+
+        ChunkHeader getChunkHeader(size_t index) const;
+        ChunkHeader getKeyframeHeader(size_t index) const;
+
+        ByteSpan getChunkData(const ChunkHeader& chunkHeader) const;
+        std::vector<uint8_t> getDecryptedChunk(const ChunkHeader& chunkHeader) const;
+        std::vector<uint8_t> getDecryptedChunk(const ChunkHeader& chunkHeader, ChunkDecoder& decoder) const;
+
+        // Session that derives the chunk key once, for decoding many chunks in a row
+        ChunkDecoder createChunkDecoder() const;
+
+        // Looks the chunk up in the cache first, decoding and caching it on a miss
+        ChunkCache::ChunkPtr getCachedChunk(const ChunkHeader& chunkHeader, ChunkDecoder& decoder, ChunkCache& cache) const;
+
+        // Decodes the given chunks (or all of them) across threadCount threads, see Chunks::decryptAndDecompressParallel
+        std::vector<Chunks::DecryptedChunk> getDecryptedChunks(const std::vector<ChunkHeader>& chunkHeaders, unsigned threadCount = 0) const;
+        std::vector<Chunks::DecryptedChunk> getDecryptedChunks(unsigned threadCount = 0) const;
+
+        // See Rofl::getChunkCheckpoints
+        std::vector<BlockReader::Checkpoint> getChunkCheckpoints(unsigned threadCount = 0) const;
+
+        // See Rofl::seekToTime; the keyframe and chunk tables are searched in place
+        SeekResult seekToTime(float seconds,
+                              const std::vector<BlockReader::Checkpoint>& checkpoints = std::vector<BlockReader::Checkpoint>()) const;
+
+        /**
+         * \throws std::runtime_error if the file can't be mapped
+         * \throws ParseException if the file is truncated or malformed
+         */
+        static RoflView open(const std::string& path);
+    };
+}
+
+#endif /* defined(__libol__RoflView__) */
@@ -1,217 +1,262 @@
 #include "Value.h"
+#include "JsonWriter.h"
 
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <stdexcept>
+#include <utility>
+
+// Slots in the key table; it's full at three quarters, to keep probes short
+#define KEY_TABLE_SIZE (16 * 1024)
 
 namespace libol {
-    Value Value::create(Object &val) {
-        Value value;
-        value.type = OBJECT;
-        value.value = new Object(val);
-        return value;
+    // Open-addressed, insert-only, so lookups never take a lock
+    static std::atomic<const char*> keyTable[KEY_TABLE_SIZE];
+    static std::atomic<size_t> keyCount(0);
+
+    static const char* intern(const char* name, size_t length) {
+        uint32_t hash = 2166136261u; // FNV-1a
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+        }
+
+        for (size_t slot = hash % KEY_TABLE_SIZE; ; slot = (slot + 1) % KEY_TABLE_SIZE) {
+            const char* entry = keyTable[slot].load(std::memory_order_acquire);
+            if (!entry) {
+                if (keyCount >= KEY_TABLE_SIZE / 4 * 3) {
+                    throw std::length_error("Key: too many distinct keys");
+                }
+                char* copy = new char[length + 1];
+                memcpy(copy, name, length);
+                copy[length] = 0;
+                if (keyTable[slot].compare_exchange_strong(entry, copy)) {
+                    keyCount++;
+                    return copy;
+                }
+                delete[] copy; // another thread got there first; entry is theirs now
+            }
+            if (strncmp(entry, name, length) == 0 && entry[length] == 0) {
+                return entry;
+            }
+        }
     }
 
-    Value Value::create(Array &val) {
+    Key::Key(const char* name) : name(intern(name, strlen(name))) {}
+
+    Key::Key(const std::string& name) : name(intern(name.data(), name.size())) {}
+
+    // The payload of a new Value, in the current arena if there is one
+    template<class T, class... Args>
+    static Value make(Value::Type type, Args&&... args) {
         Value value;
-        value.type = ARRAY;
-        value.value = new Array(val);
+        value.type = type;
+        ValueArena* arena = ValueArena::current().get();
+        if (arena) {
+            value.value = new (arena->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            value.inArena = true;
+        } else {
+            value.value = new T(std::forward<Args>(args)...);
+        }
         return value;
     }
 
-    Value Value::create(float &val) {
+    Value::Value(const Value& other) : type(UNDEFINED), inArena(false), value(nullptr) {
+        switch (other.type) {
+            case OBJECT:
+                *this = make<Object>(OBJECT, other.as<Object>());
+                break;
+            case ARRAY:
+                *this = make<Array>(ARRAY, other.as<Array>());
+                break;
+            case STRING:
+                *this = make<String>(STRING, other.as<String>().data(), other.as<String>().size());
+                break;
+            default:
+                type = other.type;
+                largeInteger = other.largeInteger;
+                break;
+        }
+    }
+
+    Value& Value::operator=(const Value& other) {
+        if (this != &other) {
+            *this = Value(other);
+        }
+        return *this;
+    }
+
+    void Value::releaseSlow() {
+        switch (type) {
+            case OBJECT:
+                delete &this->as<Object>();
+                break;
+            case ARRAY:
+                delete &this->as<Array>();
+                break;
+            case STRING:
+                delete &this->as<String>();
+                break;
+            default:
+                break;
+        }
+    }
+
+    void Value::destroy() {
+        release();
+        type = UNDEFINED;
+        inArena = false;
+        value = nullptr;
+    }
+
+    Value Value::create(const Object &val) {
+        return make<Object>(OBJECT, val);
+    }
+
+    Value Value::create(Object &&val) {
+        return make<Object>(OBJECT, std::move(val));
+    }
+
+    Value Value::create(const Array &val) {
+        return make<Array>(ARRAY, val);
+    }
+
+    Value Value::create(Array &&val) {
+        return make<Array>(ARRAY, std::move(val));
+    }
+
+    Value Value::create(float val) {
         Value value;
         value.type = FLOAT;
-        value.value = new float(val);
+        value.real = val;
         return value;
     }
 
-    Value Value::create(bool &val) {
+    Value Value::create(bool val) {
         Value value;
         value.type = BOOL;
-        value.value = new bool(val);
+        value.boolean = val;
         return value;
     }
 
-    Value Value::create(uint64_t &val) {
+    Value Value::create(uint64_t val) {
         if(val & ((uint64_t) 1 << 61))
             throw std::overflow_error("Value: val too big for LARGE_INTEGER");
-        return create((int64_t &) val);
+        return create((int64_t) val);
     }
 
-    Value Value::create(uint32_t &val) {
+    Value Value::create(uint32_t val) {
         if (val >= 2147483648) {
-            int64_t large = (int64_t) val;
-            return create(large);
+            return create((int64_t) val);
         }
-        return create((int32_t &) val);
+        return create((int32_t) val);
     }
 
-    Value Value::create(uint16_t &val) {
-        int32_t intval = (int32_t) val;
-        return create(intval);
+    Value Value::create(uint16_t val) {
+        return create((int32_t) val);
     }
 
-    Value Value::create(uint8_t &val) {
-        int32_t intval = (int32_t) val;
-        return create(intval);
+    Value Value::create(uint8_t val) {
+        return create((int32_t) val);
     }
 
-    Value Value::create(int64_t &val) {
+    Value Value::create(int64_t val) {
         Value value;
         value.type = LARGE_INTEGER;
-        value.value = new int64_t(val);
+        value.largeInteger = val;
         return value;
     }
 
-    Value Value::create(int32_t &val) {
+    Value Value::create(int32_t val) {
         Value value;
         value.type = INTEGER;
-        value.value = new int32_t(val);
+        value.integer = val;
         return value;
     }
 
-    Value Value::create(int16_t &val) {
-        int32_t intval = (int32_t) val;
-        return create(intval);
+    Value Value::create(int16_t val) {
+        return create((int32_t) val);
     }
 
-    Value Value::create(int8_t &val) {
-        int32_t intval = (int32_t) val;
-        return create(intval);
+    Value Value::create(int8_t val) {
+        return create((int32_t) val);
     }
 
-    Value Value::create(std::string &val) {
-        Value value;
-        value.type = STRING;
-        value.value = new std::string(val);
-        return value;
+    Value Value::create(const std::string &val) {
+        return make<String>(STRING, val.data(), val.size());
     }
 
-    Value Value::create(const char *&val) {
-        std::string str = std::string(val);
-        return create(str);
+    Value Value::create(const char *val) {
+        return make<String>(STRING, val);
     }
 
-    std::string Value::toString(size_t indent) {
-        std::stringstream result, tabs;
-        for (size_t i = 0; i < indent; i++)
-            tabs << "\t";
-        std::string indentation = tabs.str();
+    std::string Value::asString() const {
+        if (type != STRING) {
+            throw std::logic_error("Value: not a STRING");
+        }
+        const String& str = as<String>();
+        return std::string(str.data(), str.size());
+    }
 
-        switch (type) {
-            case OBJECT: {
-                Object &obj = this->as<Object>();
-                result << "{";
-                if(obj.size())
-                    result << std::endl;
-                for (auto it = obj.begin(); it != obj.end();) {
-                    result << indentation << "\t\"" << it->first << "\": ";
-                    result << it->second.toString(indent + 1);
-                    if (++it != obj.end())
-                        result << ",";
-                    result << std::endl;
-                }
-                if (obj.size())
-                    result << indentation;
-                result << "}";
-                break;
-            }
-            case ARRAY: {
-                Array &arr = this->as<Array>();
-                result << "[";
-                for (size_t i = 0; i < arr.size(); i++) {
-                    result << arr.at(i).toString(indent);
-                    if (i + 1 < arr.size())
-                        result << ",";
-                }
-                result << "]";
-                break;
-            }
-            case STRING:
-                result << "\"" << this->as<std::string>() << "\"";
-                break;
-            case INTEGER:
-                result << this->as<int32_t>();
-                break;
-            case LARGE_INTEGER:
-                result << this->as<int64_t>();
-                break;
-            case FLOAT:
-                result << this->as<float>();
-                break;
-            case BOOL:
-                result << (this->as<bool>() ? "true" : "false");
-                break;
-            default:
-                result << "undefined";
-                break;
-            case UNDEFINED:
-                break;
+    std::string Value::toString() const {
+        JsonWriter writer(JsonWriter::Pretty);
+        writer.value(*this);
+        return writer.buffer();
+    }
+
+    void Object::set(Key name, const Value& value) {
+        set(name, Value(value));
+    }
+
+    void Object::set(Key name, Value&& value) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), name, [] (const Entry& entry, const Key& key) {
+            return strcmp(entry.first.c_str(), key.c_str()) < 0;
+        });
+        if (it != entries.end() && it->first == name) {
+            return;
         }
-        return result.str();
+        entries.insert(it, Entry(name, std::move(value)));
     }
 
-    void Value::destroy() {
-        switch (type) {
-            case OBJECT: {
-                Object &obj = this->as<Object>();
-                for (auto it = obj.begin(); it != obj.end(); it++) {
-                    it->second.destroy();
-                }
-                delete &obj;
-                break;
-            }
-            case ARRAY: {
-                Array &arr = this->as<Array>();
-                for (size_t i = 0; i < arr.size(); i++) {
-                    arr.at(i).destroy();
-                }
-                delete &arr;
-                break;
+    Value& Object::get(Key name) {
+        // a pointer compare per entry beats a binary search over the names
+        for (auto& entry : entries) {
+            if (entry.first == name) {
+                return entry.second;
             }
-            case STRING:
-                delete &this->as<std::string>();
-                break;
-            case INTEGER:
-                delete &this->as<int32_t>();
-                break;
-            case LARGE_INTEGER:
-                delete &this->as<int64_t>();
-                break;
-            case FLOAT:
-                delete &this->as<float>();
-                break;
-            case BOOL:
-                delete &this->as<bool>();
-                break;
-            case UNDEFINED:
-                break;
         }
-        type = UNDEFINED;
-        value = nullptr;
+        throw std::out_of_range("Object: no such key " + std::string(name.c_str()));
     }
 
-    void Object::set(std::string name, Value value) {
-        map.insert(std::pair<std::string, Value> {name, value});
+    size_t Object::size() const {
+        return entries.size();
     }
 
-    Value Object::get(std::string name) {
-        return map.at(name);
+    void Object::reserve(size_t count) {
+        entries.reserve(count);
     }
 
-    size_t Object::size() {
-        return map.size();
+    void Array::push(const Value& value) {
+        vector.push_back(value);
     }
 
-    void Array::push(Value value) {
-        vector.push_back(value);
+    void Array::push(Value&& value) {
+        vector.push_back(std::move(value));
     }
 
-    size_t Array::size() {
+    size_t Array::size() const {
         return vector.size();
     }
 
-    Value Array::at(size_t index) {
+    void Array::reserve(size_t count) {
+        vector.reserve(count);
+    }
+
+    Value& Array::at(size_t index) {
+        return vector.at(index);
+    }
+
+    const Value& Array::at(size_t index) const {
         return vector.at(index);
     }
 }
@@ -4,8 +4,12 @@
 #ifndef __libol__Value__
 #define __libol__Value__
 
+#include "ValueArena.h"
+
 #include <string>
-#include <map>
+#include <ostream>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <cstdint>
 
@@ -15,95 +19,229 @@ namespace libol {
 
     class Value {
     public:
-        enum {
+        // Strings in a Value, whose characters live in the same place as the Value, see ValueArena
+        typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> String;
+
+        enum Type : uint8_t {
             UNDEFINED,
             OBJECT, // Object
             ARRAY, // Array
-            STRING, // std::string
+            STRING, // Value::String
             INTEGER, // int32_t
             LARGE_INTEGER, // int64_t
             FLOAT, // float
             BOOL // bool
         } type;
-        void *value;
+        bool inArena; // value lives in a ValueArena, and is freed with it rather than by destroy
+
+        // Scalars are kept inline; the rest are behind value
+        union {
+            void *value;
+            int32_t integer;
+            int64_t largeInteger;
+            float real;
+            bool boolean;
+        };
+
+        Value() : type(UNDEFINED), inArena(false), value(nullptr) {
+        }
+
+        // Copies are deep, into the current arena if there is one; moves take the payload over
+        Value(const Value& other);
+        Value& operator=(const Value& other);
+
+        Value(Value&& other) noexcept : type(other.type), inArena(other.inArena), largeInteger(other.largeInteger) {
+            other.type = UNDEFINED;
+            other.inArena = false;
+            other.value = nullptr;
+        }
+
+        Value& operator=(Value&& other) noexcept {
+            if (this != &other) {
+                release();
+                type = other.type;
+                inArena = other.inArena;
+                largeInteger = other.largeInteger;
+                other.type = UNDEFINED;
+                other.inArena = false;
+                other.value = nullptr;
+            }
+            return *this;
+        }
 
-        Value() : type(UNDEFINED), value(nullptr) {
+        ~Value() {
+            release();
         }
 
+        // Frees the value and everything under it now rather than on destruction
         void destroy();
 
         template<class T>
         T &as() {
+            static_assert(!std::is_same<T, std::string>::value, "STRING values are Value::String; use as<Value::String>() or asString()");
             return *reinterpret_cast<T *>(value);
         }
 
-        std::string toString(size_t indent = 0);
+        template<class T>
+        const T &as() const {
+            return const_cast<Value *>(this)->as<T>();
+        }
+
+        /**
+         * A copy of a STRING value; as<Value::String>() reads it in place
+         * \throws std::logic_error if this isn't a STRING
+         */
+        std::string asString() const;
+
+        // Pretty-printed JSON, see JsonWriter
+        std::string toString() const;
+
+        static Value create(const Object &val);
+
+        static Value create(Object &&val);
+
+        static Value create(const Array &val);
 
-        static Value create(Object &val);
+        static Value create(Array &&val);
 
-        static Value create(Array &val);
+        static Value create(const std::string &val);
 
-        static Value create(std::string &val);
+        static Value create(const char *val);
 
-        static Value create(const char *&val);
+        static Value create(uint64_t val);
 
-        static Value create(uint64_t &val);
+        static Value create(uint32_t val);
 
-        static Value create(uint32_t &val);
+        static Value create(uint16_t val);
 
-        static Value create(uint16_t &val);
+        static Value create(uint8_t val);
 
-        static Value create(uint8_t &val);
+        static Value create(int64_t val);
 
-        static Value create(int64_t &val);
+        static Value create(int32_t val);
 
-        static Value create(int32_t &val);
+        static Value create(int16_t val);
 
-        static Value create(int16_t &val);
+        static Value create(int8_t val);
 
-        static Value create(int8_t &val);
+        static Value create(float val);
 
-        static Value create(float &val);
+        static Value create(bool val);
 
-        static Value create(bool &val);
+    private:
+        // Frees the payload unless it's in an arena, leaving the fields as they are
+        void release() {
+            if ((type == OBJECT || type == ARRAY || type == STRING) && !inArena) {
+                releaseSlow();
+            }
+        }
+
+        void releaseSlow();
+    };
+
+    template<>
+    inline int32_t &Value::as<int32_t>() {
+        return integer;
+    }
+
+    template<>
+    inline int64_t &Value::as<int64_t>() {
+        return largeInteger;
+    }
+
+    template<>
+    inline float &Value::as<float>() {
+        return real;
+    }
+
+    template<>
+    inline bool &Value::as<bool>() {
+        return boolean;
+    }
+
+    // An interned Object key. Every key with the same name shares one copy
+    // of it, so keys compare by pointer. Names are kept for the life of the
+    // program, and there's room for a few thousand distinct ones.
+    class Key {
+        const char* name;
+    public:
+        Key(const char* name);
+        Key(const std::string& name);
+
+        const char* c_str() const { return name; }
+
+        bool operator==(const Key& other) const { return name == other.name; }
+        bool operator!=(const Key& other) const { return name != other.name; }
     };
 
+    inline std::ostream& operator<<(std::ostream& os, const Key& key) {
+        return os << key.c_str();
+    }
+
+    // Entries are kept in a flat vector sorted by key name, the order they
+    // used to come out of a std::map in
     class Object {
-        std::map<std::string, Value> map;
+        typedef std::pair<Key, Value> Entry;
+        typedef std::vector<Entry, ArenaAllocator<Entry>> Entries;
+        Entries entries;
     public:
         template<class T>
-        void setv(std::string name, T value) {
-            set(name, Value::create(value));
+        void setv(Key name, T&& value) {
+            set(name, Value::create(std::forward<T>(value)));
         }
 
-        void set(std::string name, Value value);
+        // The first value set for a name is kept; later ones are dropped
+        void set(Key name, const Value& value);
+        void set(Key name, Value&& value);
+
+        /**
+         * \throws std::out_of_range if name isn't set
+         */
+        Value& get(Key name);
 
-        Value get(std::string name);
+        size_t size() const;
 
-        size_t size();
+        // Room for count entries, so setting that many takes one allocation and no slack
+        void reserve(size_t count);
+
+        Entries::iterator begin() {
+            return entries.begin();
+        }
 
-        std::map<std::string, Value>::iterator begin() {
-            return map.begin();
+        Entries::iterator end() {
+            return entries.end();
         }
 
-        std::map<std::string, Value>::iterator end() {
-            return map.end();
+        Entries::const_iterator begin() const {
+            return entries.begin();
+        }
+
+        Entries::const_iterator end() const {
+            return entries.end();
         }
     };
 
     class Array {
-        std::vector<Value> vector;
+        std::vector<Value, ArenaAllocator<Value>> vector;
     public:
         template<class T>
-        void pushv(T value) {
-            push(Value::create(value));
+        void pushv(T&& value) {
+            push(Value::create(std::forward<T>(value)));
         }
 
-        void push(Value value);
+        void push(const Value& value);
+        void push(Value&& value);
+
+        size_t size() const;
 
-        size_t size();
+        // Room for count values, so pushing that many takes one allocation and no slack
+        void reserve(size_t count);
 
-        Value at(size_t index);
+        /**
+         * \throws std::out_of_range if index is past the end
+         */
+        Value& at(size_t index);
+        const Value& at(size_t index) const;
     };
 }
 
@@ -0,0 +1,63 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#include "ValueArena.h"
+
+#include <algorithm>
+
+// Room for a few hundred small packets before the next slab
+#define ARENA_SLAB_SIZE (64 * 1024)
+
+namespace libol {
+    static thread_local std::shared_ptr<ValueArena> currentArena;
+
+    ValueArena::ValueArena() : slabIndex(0), pos(nullptr), end(nullptr), used(0) {}
+
+    void* ValueArena::allocateSlow(size_t size, size_t align) {
+        // move on to the next slab that fits, keeping the ones in between for after a reset
+        if (pos) {
+            used += slabs[slabIndex].size;
+            slabIndex++;
+        }
+        while (slabIndex < slabs.size() && slabs[slabIndex].size < size + align) {
+            used += slabs[slabIndex].size;
+            slabIndex++;
+        }
+        if (slabIndex == slabs.size()) {
+            Slab slab;
+            slab.size = std::max<size_t>(ARENA_SLAB_SIZE, size + align);
+            slab.data.reset(new uint8_t[slab.size]);
+            slabs.push_back(std::move(slab));
+        }
+
+        pos = slabs[slabIndex].data.get();
+        end = pos + slabs[slabIndex].size;
+        return allocate(size, align);
+    }
+
+    void ValueArena::reset() {
+        slabIndex = 0;
+        used = 0;
+        pos = slabs.empty() ? nullptr : slabs[0].data.get();
+        end = slabs.empty() ? nullptr : pos + slabs[0].size;
+    }
+
+    size_t ValueArena::size() const {
+        if (!pos) {
+            return 0;
+        }
+        return used + (pos - slabs[slabIndex].data.get());
+    }
+
+    const std::shared_ptr<ValueArena>& ValueArena::current() {
+        return currentArena;
+    }
+
+    ValueArena::Scope::Scope(std::shared_ptr<ValueArena> arena) : previous(std::move(currentArena)) {
+        currentArena = std::move(arena);
+    }
+
+    ValueArena::Scope::~Scope() {
+        currentArena = std::move(previous);
+    }
+}
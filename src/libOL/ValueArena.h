@@ -0,0 +1,109 @@
+// Copyright (c) 2014 Andrew Toulouse.
+// Distributed under the MIT License.
+
+#ifndef __libol__ValueArena__
+#define __libol__ValueArena__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace libol {
+    // Bump allocator for Value trees. While a Scope is active on a thread,
+    // every Value created on it, and the strings, maps and vectors inside
+    // them, are allocated from the scope's arena, and destroying them does
+    // nothing. The memory goes away all at once with the arena, however
+    // many values were built in it. A tree has to be built either entirely
+    // inside a scope or entirely outside one.
+    class ValueArena {
+        struct Slab {
+            std::unique_ptr<uint8_t[]> data;
+            size_t size;
+        };
+
+        std::vector<Slab> slabs;
+        size_t slabIndex; // the slab being filled
+        uint8_t* pos;
+        uint8_t* end;
+        size_t used; // bytes in the slabs before slabIndex
+
+        void* allocateSlow(size_t size, size_t align);
+
+    public:
+        ValueArena();
+        ValueArena(const ValueArena&) = delete;
+        ValueArena& operator=(const ValueArena&) = delete;
+
+        void* allocate(size_t size, size_t align) {
+            uintptr_t start = (reinterpret_cast<uintptr_t>(pos) + align - 1) & ~(uintptr_t) (align - 1);
+            if (start + size <= reinterpret_cast<uintptr_t>(end)) {
+                pos = reinterpret_cast<uint8_t*>(start + size);
+                return reinterpret_cast<void*>(start);
+            }
+            return allocateSlow(size, align);
+        }
+
+        // Forgets everything allocated, keeping the slabs for reuse. Values
+        // still pointing into the arena are left dangling.
+        void reset();
+
+        // Bytes handed out since construction or the last reset, including alignment padding
+        size_t size() const;
+
+        // The arena of the innermost Scope on this thread, or null if there isn't one
+        static const std::shared_ptr<ValueArena>& current();
+
+        // Makes arena the current one on this thread until the scope goes away
+        class Scope {
+            std::shared_ptr<ValueArena> previous;
+        public:
+            explicit Scope(std::shared_ptr<ValueArena> arena);
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            ~Scope();
+        };
+    };
+
+    // STL allocator for the containers inside Values: from the arena current
+    // when it was created, or the heap if there was none
+    template<class T>
+    class ArenaAllocator {
+        template<class U> friend class ArenaAllocator;
+        ValueArena* arena;
+
+    public:
+        typedef T value_type;
+
+        ArenaAllocator() : arena(ValueArena::current().get()) {}
+        explicit ArenaAllocator(ValueArena* arena) : arena(arena) {}
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+        // Copies of a container go where new values would, not where the original is
+        ArenaAllocator select_on_container_copy_construction() const {
+            return ArenaAllocator();
+        }
+
+        T* allocate(size_t count) {
+            if (arena) {
+                return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+            }
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t) {
+            if (!arena) {
+                ::operator delete(pointer);
+            }
+        }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+        template<class U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+    };
+}
+
+#endif /* defined(__libol__ValueArena__) */
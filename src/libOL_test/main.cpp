@@ -7,11 +7,16 @@
 #include <string>
 #include <cassert>
 #include <cstring>
+#include <chrono>
 
+#include <libOL/Blowfish/Blowfish.h>
 #include <libOL/Chunks.h>
+#include <libOL/Inflate/Inflate.h>
 #include <libOL/Rofl.h>
+#include <libOL/RoflView.h>
 #include <libOL/BlockReader.h>
 #include <libOL/Packet.h>
+#include <libOL/JsonWriter.h>
 
 #define MAX_ARGUMENT_LENGTH 600
 
@@ -26,9 +31,7 @@ int test_blocks(std::vector<std::string> arguments)
     }
 
     libol::BlockReader reader;
-    auto blocks = reader.readBlocksFromStream(ifs);
-
-    for(auto& block : blocks) {
+    for(auto& block : reader.blocks(ifs)) {
         std::cout << std::hex << "[0x" << block.offset << "]\t";
         std::cout << std::dec << "time: " << block.time << "s\t";
         std::cout << std::hex << "type: 0x" << (unsigned) block.type << "\t";
@@ -41,7 +44,8 @@ int test_blocks(std::vector<std::string> arguments)
 
 int test_packets(std::vector<std::string> arguments)
 {
-    assert(arguments.size() == 1);
+    assert(arguments.size() == 1 || arguments.size() == 2);
+    bool ndjson = arguments.size() == 2 && arguments.at(1) == "ndjson";
 
     std::ifstream ifs(arguments.at(0), std::ios::binary);
     if (!ifs) {
@@ -49,15 +53,32 @@ int test_packets(std::vector<std::string> arguments)
         return 2;
     }
 
+    // one packet per line in ndjson, otherwise the name and the pretty-printed packet
+    libol::JsonWriter writer(stdout, ndjson ? libol::JsonWriter::Compact : libol::JsonWriter::Pretty);
     libol::BlockReader reader;
-    auto blocks = reader.readBlocksFromStream(ifs);
-
-    for(auto block : blocks) {
-        libol::Packet pkt = libol::Packet::decode(block);
-        if(pkt.isDecoded) {
-            std::cout << pkt.typeName << ": " << pkt.data.toString() << std::endl;
+    try {
+        for(auto& block : reader.blocks(ifs)) {
+            libol::Packet pkt = libol::Packet::decode(block);
+            if(!pkt.isDecoded) {
+                continue;
+            }
+            if (ndjson) {
+                writer.beginObject();
+                writer.key("type").value(pkt.typeName().c_str());
+                writer.key("time").value(block.time);
+                writer.key("entityId").value(block.entityId);
+                writer.key("data").value(pkt.data);
+                writer.endObject();
+            } else {
+                writer.raw(pkt.typeName().c_str()).raw(": ").value(pkt.data);
+            }
+            writer.end();
         }
+    } catch (libol::ParseException&) {
+        writer.flush(); // the packets before the bad one
+        throw;
     }
+    writer.flush();
 
     return 0;
 }
@@ -81,8 +102,159 @@ int test_rofl(std::vector<std::string> arguments)
     return 0;
 }
 
+int test_roflview(std::vector<std::string> arguments)
+{
+    assert(arguments.size() == 1);
+
+    libol::RoflView rofl = libol::RoflView::open(arguments.at(0));
+
+    for (auto& chunk : rofl.getDecryptedChunks()) {
+        std::cout << "chunk " << chunk.chunkId << ": " << chunk.bytes.size() << " bytes" << std::endl;
+    }
+
+    return 0;
+}
+
+int test_seek(std::vector<std::string> arguments)
+{
+    assert(arguments.size() == 2);
+
+    libol::RoflView rofl = libol::RoflView::open(arguments.at(0));
+    libol::SeekResult seek = rofl.seekToTime(std::stof(arguments.at(1)));
+
+    if (seek.hasKeyframe) {
+        std::cout << "keyframe " << seek.keyframe.chunkId << ": " << seek.keyframeBlocks.size() << " blocks" << std::endl;
+    }
+    for(auto& block : seek.blocks) {
+        std::cout << std::dec << "time: " << block.time << "s\t";
+        std::cout << std::hex << "type: 0x" << (unsigned) block.type << "\t";
+        std::cout << "param: 0x" << block.entityId << "\t";
+        std::cout << "size: 0x" << block.size << std::endl;
+    }
+    std::cout << std::dec << "next chunk index: " << seek.nextChunkIndex << std::endl;
+
+    return 0;
+}
+
+int test_blowfish(std::vector<std::string> arguments)
+{
+    assert(arguments.size() == 1);
+
+    libol::RoflView rofl = libol::RoflView::open(arguments.at(0));
+    libol::Blowfish::KeySchedule key(rofl.payloadHeader.getDecodedEncryptionKey());
+
+    const int passes = 20;
+    const char* names[] = {"openssl", "interleaved", "avx2"};
+    libol::Blowfish::Kernel::Id kernels[] = {
+        libol::Blowfish::Kernel::OpenSSL,
+        libol::Blowfish::Kernel::Interleaved,
+        libol::Blowfish::Kernel::AVX2
+    };
+
+    // decrypt every chunk of the replay as-is, so the sizes are real ones
+    std::vector<std::vector<uint8_t>> expected;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < rofl.payloadHeader.chunkCount; i++) {
+        auto data = rofl.getChunkData(rofl.getChunkHeader(i));
+        std::vector<uint8_t> out(data.size);
+        libol::Blowfish::rawDecrypt(data.data, out.data(), data.size, key, libol::Blowfish::Kernel::OpenSSL);
+        expected.push_back(out);
+        totalBytes += data.size;
+    }
+
+    double baseline = 0;
+    for (int k = 0; k < 3; k++) {
+        if (!libol::Blowfish::isKernelSupported(kernels[k])) {
+            std::cout << names[k] << ": not supported" << std::endl;
+            continue;
+        }
+
+        std::vector<uint8_t> out;
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < expected.size(); i++) {
+                auto data = rofl.getChunkData(rofl.getChunkHeader(i));
+                out.resize(data.size);
+                libol::Blowfish::rawDecrypt(data.data, out.data(), data.size, key, kernels[k]);
+                if (pass == 0 && out != expected[i]) {
+                    std::cerr << names[k] << ": output differs from OpenSSL in chunk " << i << std::endl;
+                    return 3;
+                }
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double mbPerSecond = totalBytes * passes / elapsed.count() / (1024 * 1024);
+        if (k == 0) {
+            baseline = mbPerSecond;
+        }
+        std::cout << names[k] << ": " << mbPerSecond << " MB/s (" << mbPerSecond / baseline << "x)" << std::endl;
+    }
+
+    return 0;
+}
+
+int test_inflate(std::vector<std::string> arguments)
+{
+    assert(arguments.size() == 1);
+
+    libol::RoflView rofl = libol::RoflView::open(arguments.at(0));
+    libol::Blowfish::KeySchedule key(rofl.payloadHeader.getDecodedEncryptionKey());
+
+    const int passes = 20;
+    const char* names[] = {"zlib", "builtin", "builtin (trusted)"};
+    std::unique_ptr<libol::Inflate::Decompressor> decompressors[] = {
+        libol::Inflate::createDecompressor(libol::Inflate::Backend::Zlib),
+        libol::Inflate::createDecompressor(libol::Inflate::Backend::Builtin),
+        libol::Inflate::createDecompressor(libol::Inflate::Backend::Builtin, true)
+    };
+
+    // decrypt every chunk up front so only inflate is timed
+    std::vector<std::vector<uint8_t>> compressed;
+    for (size_t i = 0; i < rofl.payloadHeader.chunkCount; i++) {
+        auto data = rofl.getChunkData(rofl.getChunkHeader(i));
+        std::vector<uint8_t> plaintext(data.size);
+        plaintext.resize(libol::Blowfish::decrypt(data.data, data.size, plaintext.data(), key));
+        compressed.push_back(plaintext);
+    }
+
+    std::vector<std::vector<uint8_t>> expected;
+    size_t totalBytes = 0;
+    double baseline = 0;
+    for (int d = 0; d < 3; d++) {
+        std::vector<uint8_t> out(16 * 1024 * 1024);
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (size_t i = 0; i < compressed.size(); i++) {
+                libol::ByteSpan in(compressed[i].data(), compressed[i].size());
+                size_t length = decompressors[d]->decompress(in, out.data(), out.size());
+                if (pass > 0) {
+                    continue;
+                }
+                std::vector<uint8_t> result(out.begin(), out.begin() + length);
+                if (d == 0) {
+                    totalBytes += length;
+                    expected.push_back(result);
+                } else if (result != expected[i]) {
+                    std::cerr << names[d] << ": output differs from zlib in chunk " << i << std::endl;
+                    return 3;
+                }
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double mbPerSecond = totalBytes * passes / elapsed.count() / (1024 * 1024);
+        if (d == 0) {
+            baseline = mbPerSecond;
+        }
+        std::cout << names[d] << ": " << mbPerSecond << " MB/s (" << mbPerSecond / baseline << "x)" << std::endl;
+    }
+
+    return 0;
+}
+
 int usage(std::string prog_name) {
-    std::cerr << prog_name << " [rofl|blocks|packets] <rofl/blocks/packets file>" << std::endl;
+    std::cerr << prog_name << " [rofl|roflview|seek|blowfish|inflate|blocks|packets] <rofl/blocks/packets file> [seconds|ndjson]" << std::endl;
     return 1;
 }
 
@@ -104,6 +276,14 @@ int main(int argc, const char * argv[])
 
     if (command == "rofl") {
         return test_rofl(arguments);
+    } else if (command == "roflview") {
+        return test_roflview(arguments);
+    } else if (command == "seek") {
+        return test_seek(arguments);
+    } else if (command == "blowfish") {
+        return test_blowfish(arguments);
+    } else if (command == "inflate") {
+        return test_inflate(arguments);
     } else if (command == "blocks") {
         return test_blocks(arguments);
     } else if (command == "packets") {